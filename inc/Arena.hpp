@@ -0,0 +1,37 @@
+/**
+ * @file Arena.hpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ *
+ * Bump allocation for the program nodes of the IR.
+ *
+ * Nodes, their operand arrays and parameter strings are carved out of large
+ * blocks one after another, so the nodes of a program lie next to each other
+ * in memory. Freeing a single allocation does nothing; the blocks are
+ * returned all at once when the arena is released or destroyed.
+ */
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+class Arena {
+public:
+    Arena() = default;
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &_buffer; }
+
+    /// @brief Frees every allocation; nothing allocated here may be used afterwards.
+    void release() { _buffer.release(); }
+
+private:
+    // blocks grow geometrically from here
+    static constexpr std::size_t INITIAL_BLOCK = 64 * 1024;
+
+    std::pmr::monotonic_buffer_resource _buffer{INITIAL_BLOCK};
+};
+
+/* EOF Arena.hpp */
@@ -17,11 +17,28 @@ public:
         std::string target = "stim";
         std::string input_file = "";
         std::string output_file = "";
+        std::string batch_file = "";
         bool use_algebraic = false;
         unsigned algebraic_precision = 32;
         bool decompose_mcx = false;
         bool merge_registers = false;
         bool eval_angles = false;
+        std::string passes = "";    // pipeline, e.g. "decompose-mcx,merge-registers"
+        unsigned long long unroll_budget = 1'000'000;
+        unsigned unroll_factor = 0;
+        bool report_timing = false;
+        bool report_memory = false;
+        bool fast_path = false;
+        bool report_fast_path = false;
+        bool stream = false;
+        unsigned jobs = 1;
+        bool two_pass = false;
+        bool no_library_cache = false;
+        std::string emit_ir = "";   // snapshot written after parsing
+        std::string load_ir = "";   // snapshot read instead of parsing
+        std::string cache_dir = ""; // output cache, off when empty
+        unsigned long long cache_size_mb = 1024;
+        bool report_cache = false;
     };
 
     static Args parse(int argc, const char* argv[]);
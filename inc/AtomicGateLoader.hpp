@@ -17,5 +17,6 @@
 using json = nlohmann::json;
 
 std::vector<GateDef> loadGates(const std::string& filename, bool algebraic, unsigned precision);
+AtomicGateSemantics makeAtomicSemantics(std::string string_matrix, bool algebraic, unsigned precision);
 ComplexMatrix<ACN> createAlgebraicMatrix(const std::string& json_str, unsigned precision);
 ComplexMatrix<ACN> createAlgebraicMatrixStub(unsigned precision);
\ No newline at end of file
@@ -0,0 +1,128 @@
+/**
+ * @file CircuitDag.hpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ *
+ * Dependency DAG view of one block of the program.
+ *
+ * Every gate of the block (a GateApplication, or one gate of a GateStream)
+ * becomes a node linked to the previous and next node on each qubit it acts
+ * on, so a pass can ask which gate precedes another on a qubit, walk front
+ * layers or a light cone, remove or edit gates, and commit the result back
+ * into the block.
+ *
+ * Qubits are "wires": one per qubit of every register with a constant size.
+ * Nodes whose qubits are not known exactly are opaque and act on whole
+ * registers: loops and conditionals (super-nodes for their entire body),
+ * gates with non-literal indices and gates on registers of symbolic size.
+ *
+ * Building is linear in the number of operands, plus the register sizes of
+ * the opaque nodes. The view is only valid until the block is changed by
+ * other means than commit().
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "ir.hpp"
+
+class CircuitDag {
+public:
+    using NodeId = std::uint32_t;
+    using WireId = std::uint32_t;
+
+    static constexpr NodeId NONE = static_cast<NodeId>(-1);
+
+    CircuitDag(const IR& ir, Block& block);
+
+    /// @brief Number of nodes, including removed ones; ids are 0 .. size() - 1.
+    std::size_t size() const { return _nodes.size() - 1; }
+    std::size_t wireCount() const { return _first.size(); }
+
+    bool isOpaque(NodeId node) const { return _nodes[node].opaque; }
+    bool isRemoved(NodeId node) const { return _nodes[node].removed; }
+
+    // gate nodes only (not opaque)
+    idGate gateId(NodeId node) const;
+    std::size_t paramCount(NodeId node) const;
+    std::string_view param(NodeId node, std::size_t k) const;
+    void setParam(NodeId node, std::size_t k, std::string_view value);
+
+    /// @brief The GateApplication of a node, also an opaque one; nullptr for stream gates, loops and conditionals.
+    const GateApplication* application(NodeId node) const;
+
+    /// @brief Wires of a node: the operands in order for gates, sorted for opaque nodes.
+    std::size_t arity(NodeId node) const { return _nodes[node + 1].slots - _nodes[node].slots; }
+    WireId wire(NodeId node, std::size_t slot) const { return _slots[_nodes[node].slots + slot].wire; }
+
+    /// @brief Neighbours on the wire of the given slot, NONE at either end.
+    NodeId predecessor(NodeId node, std::size_t slot) const { return _slots[_nodes[node].slots + slot].prev; }
+    NodeId successor(NodeId node, std::size_t slot) const { return _slots[_nodes[node].slots + slot].next; }
+
+    NodeId firstOn(WireId wire) const { return _first[wire]; }
+    NodeId lastOn(WireId wire) const { return _last[wire]; }
+
+    /// @brief Wire of qubit index of register reg_id, NONE if it has no wire of its own.
+    WireId wireOf(idRegister reg_id, std::ptrdiff_t index) const;
+
+    /// @brief Live nodes in program order, which is a topological order.
+    std::vector<NodeId> topologicalOrder() const;
+
+    /// @brief Live nodes without live predecessors.
+    std::vector<NodeId> frontLayer() const;
+
+    /// @brief Live nodes grouped by ASAP layer (depth) in program order.
+    std::vector<std::vector<NodeId>> layers() const;
+
+    /// @brief Live nodes the given node depends on, transitively, in program order.
+    std::vector<NodeId> pastLightCone(NodeId node) const;
+
+    /// @brief Unlinks a node; its neighbours on each wire become adjacent.
+    void remove(NodeId node);
+
+    /**
+     * @brief Writes the live nodes back into the block in program order.
+     *        Streams lose their removed gates; everything else is moved back.
+     *        The view must not be used afterwards.
+     */
+    void commit(Arena& arena);
+
+private:
+    struct Node {
+        std::uint32_t body_index;   // position in Block::body
+        std::uint32_t stream_gate;  // gate in a GateStream, NONE otherwise
+        std::uint32_t slots;        // first slot; the slots end where the next node's begin
+        bool opaque = false;
+        bool removed = false;
+    };
+
+    struct Slot {
+        WireId wire;
+        NodeId prev = NONE;
+        NodeId next = NONE;
+    };
+
+    Block& _block;
+
+    std::vector<Node> _nodes;       // plus a sentinel closing the last slot range
+    std::vector<Slot> _slots;
+    std::vector<NodeId> _first;     // per wire
+    std::vector<NodeId> _last;
+
+    // wires of the register in slot r are _wire_base[r] .. _wire_base[r] + _wire_count[r]
+    std::vector<WireId> _wire_base;
+    std::vector<std::uint32_t> _wire_count;
+    std::vector<bool> _sized;       // register has a constant size
+
+    void addNode(std::uint32_t body_index, std::uint32_t stream_gate,
+                 const std::vector<WireId>& wires, bool opaque);
+    void addRegisterWires(idRegister reg_id, std::vector<WireId>& wires) const;
+    void collectRegisters(const std::vector<ProgramNodePtr>& body, std::vector<idRegister>& regs) const;
+
+    Slot& slot(NodeId node, std::size_t k) { return _slots[_nodes[node].slots + k]; }
+    Slot& slotOn(NodeId node, WireId wire);
+};
+
+/* EOF CircuitDag.hpp */
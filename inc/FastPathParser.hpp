@@ -0,0 +1,106 @@
+/**
+ * @file FastPathParser.hpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ *
+ * Hand-written scanner and parser for the flat subset of OpenQASM 2/3 that
+ * makes up most generated circuits: version and include lines, register and
+ * const declarations, gate definitions whose bodies are plain gate calls, and
+ * top-level gate calls with literal (or plain expression) indices.
+ *
+ * The IR is built directly while scanning, without a token buffer or parse
+ * tree, and produces the same IR as GateHeadersCollector + ProgramCollector
+ * on that subset. On the first construct outside the subset the parser stops
+ * and reports failure; the caller then discards the partially built IR and
+ * takes the ANTLR path.
+ */
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ir.hpp"
+#include "ScopeManager.hpp"
+
+class FastPathParser {
+public:
+    FastPathParser(IR& ir, ScopeManager& scopes);
+
+    /**
+     * @brief Parses the whole source into the IR.
+     * @return true on success, false if an unsupported construct was found.
+     *         In the latter case the IR and scopes are left partially filled.
+     */
+    bool parse(std::string_view source);
+
+    const std::string& failureReason() const { return _failure_reason; }
+    std::size_t failureLine() const { return _failure_line; }
+
+private:
+    enum class TokenKind {
+        Identifier,
+        Integer,
+        Float,
+        String,
+        Punct,
+        End
+    };
+
+    struct Token {
+        TokenKind kind;
+        std::string_view text;
+        std::size_t line;
+    };
+
+    struct Expression {
+        std::string text;         // tokens concatenated without whitespace
+        std::size_t tokens = 0;
+        TokenKind first_kind = TokenKind::End;
+    };
+
+    // scanning
+    Token lex();
+    const Token& peek();
+    Token take();
+    Token expectPunct(char c);
+    Token expectIdentifier();
+    bool atPunct(char c);
+    [[noreturn]] void unsupported(const std::string& what) const;
+
+    // expression text, as getText() of the corresponding parse tree would give
+    Expression takeExpression(bool stop_at_comma);
+
+    // statements
+    void parseStatement();
+    void parseVersion();
+    void parseInclude();
+    void parseQubitDeclaration();
+    void parseOldStyleDeclaration(RegisterType type);
+    void parseConstDeclaration();
+    void parseGateDefinition();
+    void parseGateCall(const Token& name);
+    void parseGateBodyCall(const Token& name, GateDef& gate, std::vector<GateStmt>& body);
+
+    std::vector<std::string> parseParameterList();
+    void parseRegisterSize(RegisterDef& reg);
+    void declareRegister(RegisterDef& reg);
+    std::optional<std::ptrdiff_t> constantValue(std::string_view name) const;
+
+    IR& _ir;
+    ScopeManager& _scopes;
+
+    std::string_view _source;
+    std::size_t _pos = 0;
+    std::size_t _line = 1;
+
+    Token _lookahead{};
+    bool _has_lookahead = false;
+    bool _at_program_start = true;
+
+    std::string _failure_reason;
+    std::size_t _failure_line = 0;
+};
+
+/* EOF FastPathParser.hpp */
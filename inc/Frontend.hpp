@@ -0,0 +1,61 @@
+/**
+ * @file Frontend.hpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ *
+ * Driving the ANTLR lexer and parser over an input stream.
+ */
+#pragma once
+
+#include <antlr4-runtime/antlr4-runtime.h>
+#include "qasm3Lexer.h"
+#include "qasm3Parser.h"
+#include <chrono>
+
+namespace frontend {
+
+using Clock = std::chrono::steady_clock;
+
+/// Milliseconds since a point in time, for the timing reports.
+inline double elapsedMs(Clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - since).count();
+}
+
+enum class PredictionStage {
+    SLL,
+    LL
+};
+
+struct ParseResult {
+    qasm3Parser::ProgramContext* tree = nullptr;
+    PredictionStage stage = PredictionStage::SLL; // stage that produced the tree
+
+    double lex_ms = 0.0;
+    double sll_ms = 0.0;
+    double ll_ms = 0.0;  // zero unless the SLL stage bailed out
+};
+
+/**
+ * @brief Parses a whole program in two stages.
+ *
+ * The token stream is filled first, then the program is parsed with SLL
+ * prediction and a bail-out error strategy. SLL is exact for almost all
+ * inputs and much cheaper than full-context prediction; only when it reports
+ * a syntax error (which may be spurious under SLL) is the token stream
+ * rewound and the program re-parsed with full LL prediction and the default
+ * error reporting and recovery.
+ *
+ * @param parser The parser over tokens.
+ * @param tokens The buffered token stream the parser reads from.
+ * @param report_errors Whether the LL stage prints its syntax errors; they
+ *        are counted by the parser either way.
+ * @return The parse tree (owned by the parser) with per-stage timings.
+ */
+ParseResult parseTwoStage(qasm3Parser& parser, antlr4::CommonTokenStream& tokens,
+                          bool report_errors = true);
+
+const char* toString(PredictionStage stage);
+
+} // namespace frontend
+
+/* EOF Frontend.hpp */
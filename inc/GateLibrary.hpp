@@ -0,0 +1,84 @@
+/**
+ * @file GateLibrary.hpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ *
+ * Gate libraries: the builtin gate table and files pulled in by `include`.
+ *
+ * Both are precompiled on first use into a binary library next to the source
+ * (<source>.qlib) holding the serialized GateDefs, composite bodies and
+ * aliases included. Later runs map the library instead of parsing the JSON
+ * table or the included OpenQASM file again. A library records the size and
+ * modification time of its source and is rebuilt when they change.
+ *
+ * The standard includes (stdgates.inc, qelib1.inc) are served by the builtin
+ * gate table and are not read from disk.
+ */
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ir.hpp"
+#include "ScopeManager.hpp"
+#include "Serialize.hpp"
+
+namespace gate_library {
+
+struct Options {
+    std::vector<std::string> include_dirs;  // searched in order for included files
+    bool algebraic = false;                 // build algebraic matrices of atomic gates
+    unsigned precision = 32;
+    bool use_cache = true;                  // read and write .qlib files
+};
+
+/// @brief Sets the options used by loadGateTable() and include().
+void configure(Options options);
+
+/**
+ * @brief Loads the builtin gate table from its JSON file, or from the
+ *        precompiled library when that is up to date.
+ * @throws std::runtime_error if the table cannot be read.
+ */
+std::vector<GateDef> loadGateTable(const std::string& json_path);
+
+/**
+ * @brief Adds the gates defined by an included file to the IR and scopes.
+ *
+ * Included files may only contain gate definitions and further includes,
+ * which are looked up next to the including file first. Gates of an
+ * included file whose name is already defined (e.g. by the builtin table)
+ * are skipped, so including the same file twice is harmless. This does not
+ * apply to the program itself: redefining a gate there is an error.
+ *
+ * @param name The include path as written in the program, without quotes.
+ * @throws std::runtime_error if the file cannot be found or lowered.
+ */
+void include(const std::string& name, IR& ir, ScopeManager& scopes);
+
+bool isStandardInclude(std::string_view name);
+
+/**
+ * @brief Path of an included file: name itself if absolute, otherwise the
+ *        first match in the directory of including_file (when given) and
+ *        the configured include directories.
+ * @throws std::runtime_error if the file does not exist.
+ */
+std::string resolveInclude(const std::string& name, const std::string& including_file = "");
+
+/// @brief The include path of a string literal token, without its quotes.
+std::string includeName(std::string_view literal);
+
+/**
+ * @brief Serialized form of a gate in a library, also used by IR snapshots.
+ *
+ * The used flag is not stored. Placements in composite bodies are stored by
+ * gate name and read back as ProgramCollector::UNRESOLVED_GATE; atomic
+ * matrices are rebuilt with the configured algebraic options.
+ */
+void writeGate(serialize::Writer& out, const GateDef& gate);
+GateDef readGate(serialize::Reader& in);
+
+} // namespace gate_library
+
+/* EOF GateLibrary.hpp */
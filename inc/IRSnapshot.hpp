@@ -0,0 +1,45 @@
+/**
+ * @file IRSnapshot.hpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ *
+ * Binary snapshots of a built IR (--emit-ir / --load-ir).
+ *
+ * A snapshot holds everything the passes and printers read: registers, gates
+ * (composite bodies and repeat blocks included), subroutines and the global
+ * block tree with its GateStreams. It is position independent: registers,
+ * gates and subroutines are referred to by id, loop variables in indices by
+ * name, so a snapshot can be loaded by any later run of the same version.
+ *
+ * Loading maps the file and builds the IR straight from the mapped bytes.
+ * GateStream arrays are stored in their in-memory layout and copied into the
+ * arena in one block each, so reloading a packed program costs little more
+ * than reading the file.
+ */
+#pragma once
+
+#include <string>
+#include "ir.hpp"
+
+namespace ir_snapshot {
+
+/**
+ * @brief Writes a snapshot of ir to path (atomically, see Serialize.hpp).
+ * @throws std::runtime_error if the file cannot be written.
+ */
+void save(const IR& ir, const std::string& path);
+
+/**
+ * @brief Loads a snapshot into ir, which must be empty.
+ *
+ * Atomic gate matrices are rebuilt with the options passed to
+ * gate_library::configure().
+ *
+ * @throws std::runtime_error if the file is missing, truncated, corrupt or
+ *         was written by another format version.
+ */
+void load(const std::string& path, IR& ir);
+
+} // namespace ir_snapshot
+
+/* EOF IRSnapshot.hpp */
@@ -0,0 +1,93 @@
+/**
+ * @file Interner.hpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ *
+ * Process-wide table of identifier names.
+ *
+ * Every distinct name (register, gate, subroutine, variable...) is stored
+ * once and identified by a small integer, so the name tables of the IR and
+ * the ScopeManager hash and compare integers instead of strings. Ids are
+ * never reused and names stay at a stable address for the whole run.
+ *
+ * Definitions (registers, gates, subroutines, scope symbols) hold their
+ * name as an InternedName: the id plus a pointer to the interned text.
+ */
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <ostream>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+using SymbolId = std::uint32_t;
+
+class Interner {
+public:
+    /// @brief The interner shared by the IR, scopes and printers.
+    static Interner& global();
+
+    /// @brief The id of name, adding the name if it is new.
+    SymbolId intern(std::string_view name);
+
+    /// @brief The id of name if it was interned already; never adds it.
+    std::optional<SymbolId> find(std::string_view name) const;
+
+    /// @throws std::out_of_range for an id that was not handed out.
+    std::string_view name(SymbolId id) const;
+    /// @brief The stored name, valid for the whole run.
+    const std::string& text(SymbolId id) const;
+
+    std::size_t size() const;
+
+private:
+    // lowering runs on several threads in the parallel frontend
+    mutable std::shared_mutex _mutex;
+    std::deque<std::string> _names;   // deque: elements never move
+    std::unordered_map<std::string_view, SymbolId> _ids;
+};
+
+/// @brief Shorthands for Interner::global().
+inline SymbolId intern(std::string_view name) { return Interner::global().intern(name); }
+inline std::string_view symbolName(SymbolId id) { return Interner::global().name(id); }
+
+/**
+ * A name stored once in the global interner. Converts to const std::string&
+ * without a lookup; two names compare by id.
+ */
+class InternedName {
+public:
+    InternedName() : InternedName(std::string_view{}) {}
+    InternedName(std::string_view name) : _id(intern(name)), _text(&Interner::global().text(_id)) {}
+    InternedName(const std::string& name) : InternedName(std::string_view(name)) {}
+    InternedName(const char* name) : InternedName(std::string_view(name)) {}
+
+    SymbolId id() const { return _id; }
+    const std::string& str() const { return *_text; }
+    std::string_view view() const { return *_text; }
+    bool empty() const { return _text->empty(); }
+
+    operator const std::string&() const { return *_text; }
+
+    bool operator==(const InternedName& other) const { return _id == other._id; }
+    bool operator==(std::string_view other) const { return *_text == other; }
+    bool operator==(const std::string& other) const { return *_text == other; }
+    bool operator==(const char* other) const { return *_text == other; }
+
+    friend std::string operator+(const std::string& a, const InternedName& b) { return a + *b._text; }
+    friend std::string operator+(std::string&& a, const InternedName& b) { return std::move(a) + *b._text; }
+    friend std::string operator+(const char* a, const InternedName& b) { return a + *b._text; }
+    friend std::string operator+(const InternedName& a, const std::string& b) { return *a._text + b; }
+    friend std::string operator+(const InternedName& a, const char* b) { return *a._text + b; }
+    friend std::ostream& operator<<(std::ostream& out, const InternedName& name) { return out << *name._text; }
+
+private:
+    SymbolId _id;
+    const std::string* _text;
+};
+
+/* EOF Interner.hpp */
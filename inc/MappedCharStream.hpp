@@ -0,0 +1,103 @@
+/**
+ * @file MappedCharStream.hpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ *
+ * Zero-copy ANTLR character stream over a memory-mapped input file.
+ *
+ * ANTLRInputStream reads the whole input through an iostream and converts it
+ * to a UTF-32 buffer, which costs several times the file size before lexing
+ * starts. MappedCharStream instead maps the file read-only and decodes UTF-8
+ * on the fly, so the lexer works directly over the mapped bytes. Stream
+ * indices are byte offsets; they are only ever produced by index() and fed
+ * back through seek() and getText(), so they always fall on code point
+ * boundaries.
+ *
+ * Inputs that cannot be mapped (pipes, terminals) are read into an owned
+ * buffer with a single bulk read.
+ */
+#pragma once
+
+#include <antlr4-runtime/antlr4-runtime.h>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+class MappedCharStream : public antlr4::CharStream {
+public:
+    /**
+     * @brief Maps the given file into memory.
+     * @throws std::runtime_error if the file cannot be opened or read.
+     */
+    static std::unique_ptr<MappedCharStream> fromFile(const std::string& path);
+
+    /**
+     * @brief Maps standard input when it is redirected from a regular file,
+     *        otherwise reads it into an owned buffer.
+     * @throws std::runtime_error if reading fails.
+     */
+    static std::unique_ptr<MappedCharStream> fromStdin();
+
+    ~MappedCharStream() override;
+
+    MappedCharStream(const MappedCharStream&) = delete;
+    MappedCharStream& operator=(const MappedCharStream&) = delete;
+
+    // IntStream
+    void consume() override;
+    size_t LA(ssize_t i) override;
+    ssize_t mark() override;
+    void release(ssize_t marker) override;
+    size_t index() override;
+    void seek(size_t index) override;
+    size_t size() override;
+    std::string getSourceName() const override;
+
+    // CharStream
+    std::string getText(const antlr4::misc::Interval& interval) override;
+    std::string toString() const override;
+
+    /**
+     * @brief Returns the raw bytes between two stream indices (inclusive),
+     *        without copying. Valid as long as the stream is alive.
+     */
+    std::string_view view(size_t start, size_t stop) const;
+
+    /// @brief The whole input as raw bytes.
+    std::string_view contents() const { return std::string_view(_data, _size); }
+
+    /**
+     * @brief A stream over the bytes [start, stop) of this one, sharing its
+     *        storage. Indices of the slice start at zero; the slice must not
+     *        outlive this stream.
+     */
+    std::unique_ptr<MappedCharStream> slice(size_t start, size_t stop) const;
+
+    /**
+     * @brief Hints that the bytes before index will not be read again, so the
+     *        kernel may drop their pages. Reading them later is still valid
+     *        (the pages are faulted back in from the file); no-op for
+     *        buffered input.
+     */
+    void releaseBefore(size_t index);
+
+private:
+    MappedCharStream(std::string source_name);
+
+    static std::unique_ptr<MappedCharStream> fromDescriptor(int fd, std::string source_name);
+
+    // decodes the UTF-8 sequence starting at pos, stores its byte length in len
+    size_t decodeAt(size_t pos, size_t& len) const;
+
+    const char* _data = nullptr;
+    size_t _size = 0;
+    size_t _pos = 0;
+
+    void* _mapping = nullptr;   // non-null if _data points into an mmap region
+    size_t _released = 0;       // mapped prefix already handed back by releaseBefore
+    std::string _buffer;        // owns the data when the input is not mappable
+    std::string _source_name;
+};
+
+/* EOF MappedCharStream.hpp */
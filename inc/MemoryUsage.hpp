@@ -0,0 +1,32 @@
+/**
+ * @file MemoryUsage.hpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ *
+ * Resident memory of the running process, read from /proc/self/status.
+ */
+#pragma once
+
+#include <cstddef>
+
+namespace memory {
+
+struct Usage {
+    std::size_t rss_kb = 0;    // current resident set size (VmRSS)
+    std::size_t peak_kb = 0;   // peak resident set size (VmHWM)
+};
+
+/// @brief Current and peak RSS; zeros where /proc is not available.
+Usage current();
+
+/**
+ * @brief Resets the peak RSS to the current RSS, so that the next current()
+ *        reports the peak of the phase in between.
+ * @return false if the kernel does not support resetting the peak; the peak
+ *         then keeps covering the whole run.
+ */
+bool resetPeak();
+
+} // namespace memory
+
+/* EOF MemoryUsage.hpp */
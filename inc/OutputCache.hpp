@@ -0,0 +1,92 @@
+/**
+ * @file OutputCache.hpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ *
+ * Content-addressed cache of printer output (--cache-dir).
+ *
+ * An entry is keyed by a hash of everything the output depends on: the
+ * input bytes, the contents of the files it includes, the options that
+ * change the output (target, algebraic precision, passes), the builtin gate
+ * table and the qfront binary itself, so a rebuilt qfront never sees entries
+ * of an older one. A hit skips parsing, passes and printing and copies the
+ * stored output.
+ *
+ * Entries are plain files named by their key. A hit refreshes the file's
+ * modification time. The cache keeps a running total of the entry sizes,
+ * read from the directory at the first store. Once a store takes it over
+ * the size limit, the directory is scanned again (other processes may
+ * share it) and the least recently used entries are removed down to 90% of
+ * the limit, so a full cache is not rescanned on every store. Writes are
+ * atomic, so several qfront processes can share one directory.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "ArgParser.hpp"
+#include "MappedCharStream.hpp"
+
+class OutputCache {
+public:
+    struct Stats {
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+        std::size_t stored = 0;
+        std::size_t evicted = 0;
+        std::uint64_t evicted_bytes = 0;
+    };
+
+    /**
+     * @param max_bytes Size limit of all entries together.
+     * @throws std::runtime_error if the directory cannot be created.
+     */
+    OutputCache(std::string dir, std::uint64_t max_bytes);
+
+    /**
+     * @brief Key of the output for input under args, or nullopt if the input
+     *        cannot be cached (e.g. an included file is missing; the frontend
+     *        reports that properly). Includes are resolved with the options
+     *        passed to gate_library::configure().
+     */
+    std::optional<std::string> key(std::string_view input, const ArgParser::Args& args) const;
+
+    /// @brief The stored output for key, nullptr on a miss.
+    std::unique_ptr<MappedCharStream> fetch(const std::string& key);
+
+    /// @brief Stores output under key and evicts old entries; failures are ignored.
+    void store(const std::string& key, std::string_view output);
+    /// @brief Same as store(), with the output read from a file.
+    void storeFile(const std::string& key, const std::string& path);
+
+    const Stats& stats() const { return _stats; }
+
+private:
+    std::string _dir;
+    std::uint64_t _max_bytes;
+    Stats _stats;
+
+    struct Entry {
+        std::filesystem::file_time_type used;
+        std::uint64_t size;
+        std::string key;
+    };
+
+    // running total of the directory, nullopt until the first store
+    std::optional<std::uint64_t> _total;
+    std::unordered_map<std::string, std::uint64_t> _sizes;   // by key
+
+    std::string entryPath(const std::string& key) const;
+    /// @brief Lists the entries on disk and resets _total and _sizes to them.
+    std::vector<Entry> scan();
+    void evict();
+};
+
+/* EOF OutputCache.hpp */
@@ -0,0 +1,67 @@
+/**
+ * @file ParallelFrontend.hpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ *
+ * Parsing one large input on several cores.
+ *
+ * The input is cut at top-level semicolons (outside braces, comments and
+ * strings, and not before an `else`) into chunks of roughly equal size, and every chunk is lexed and
+ * parsed by its own lexer/parser on a worker thread. Declarations (includes,
+ * gates, subroutines, registers, constants) are then collected sequentially in
+ * source order, so ids come out exactly as in the single-threaded frontend.
+ * Finally the remaining statements of every chunk are lowered concurrently
+ * into per-chunk blocks, which are appended to the global block in chunk
+ * order. A chunk starts from the scope as it was at its first statement, and
+ * its registers and constants become visible at their declarations, so a use
+ * before the declaration is rejected as in the single-threaded frontend.
+ */
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+#include "MappedCharStream.hpp"
+#include "ScopeManager.hpp"
+#include "ir.hpp"
+
+namespace frontend {
+
+struct Chunk {
+    size_t begin = 0;   // byte range [begin, end) of the input
+    size_t end = 0;
+    size_t line = 1;    // line number at begin
+};
+
+/**
+ * @brief Splits source after top-level semicolons into at most count chunks
+ *        of at least min_size bytes each (except possibly the last one).
+ */
+std::vector<Chunk> splitTopLevel(std::string_view source, size_t count, size_t min_size);
+
+struct ParallelStats {
+    size_t chunks = 0;
+    size_t ll_chunks = 0;   // chunks whose SLL parse bailed out
+    bool syntax_errors = false;   // some chunk did not parse, the IR was left as it was
+
+    double split_ms = 0.0;
+    double parse_ms = 0.0;
+    double declarations_ms = 0.0;
+    double lowering_ms = 0.0;
+};
+
+/**
+ * @brief Parses the input with up to jobs threads and builds the IR.
+ *
+ * The IR and scopes must already hold the builtin gates. Errors are reported
+ * for the first failing chunk in source order. If any chunk has syntax
+ * errors, nothing is added to the IR and stats.syntax_errors is set; the
+ * input should then be parsed sequentially, which reports them.
+ *
+ * @throws std::runtime_error on semantic errors.
+ */
+ParallelStats parseParallel(MappedCharStream& input, IR& ir, ScopeManager& scopes, unsigned jobs);
+
+} // namespace frontend
+
+/* EOF ParallelFrontend.hpp */
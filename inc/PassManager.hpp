@@ -0,0 +1,113 @@
+/**
+ * @file PassManager.hpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ *
+ * Named passes run as a pipeline (--passes=a,b,c).
+ *
+ * Every pass is registered under a name and reports which cached analyses
+ * it changed; the others stay valid for the next pass. The analyses are
+ * built on first use: the CircuitDag of the global block, the wires with at
+ * least one gate on them (qubit liveness) and the number of gate
+ * applications per gate (static, a loop body counts once).
+ *
+ * Each pass can report its wall time and the IR size before and after
+ * (gates, registers and live qubits, read off the cached analyses). The
+ * DAG-based passes (cancel, merge-rotations) work on the cached DAG, so
+ * one that changes nothing leaves it for the next.
+ */
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ir.hpp"
+#include "CircuitDag.hpp"
+#include "Passes.hpp"
+
+namespace passes {
+
+/// @brief Bit set of cached analyses.
+using Analyses = unsigned;
+
+inline constexpr Analyses NO_ANALYSES = 0;
+inline constexpr Analyses DAG = 1u << 0;
+inline constexpr Analyses QUBIT_LIVENESS = 1u << 1;
+inline constexpr Analyses GATE_COUNTS = 1u << 2;
+inline constexpr Analyses ALL_ANALYSES = DAG | QUBIT_LIVENESS | GATE_COUNTS;
+
+/**
+ * Lazily built analyses of one IR. A pass that edits the program through
+ * dag() must commit it and report DAG as changed.
+ */
+class AnalysisCache {
+public:
+    explicit AnalysisCache(IR& ir) : _ir(ir) {}
+
+    CircuitDag& dag();
+    /// @brief Per wire of dag(): whether any node (gate or opaque) acts on it.
+    const std::vector<bool>& qubitLiveness();
+    /// @brief Gate applications per slotIndex() of the gate id.
+    const std::vector<std::size_t>& gateCounts();
+    /// @brief Sum of gateCounts().
+    std::size_t gateTotal();
+
+    void invalidate(Analyses changed);
+
+private:
+    IR& _ir;
+    std::unique_ptr<CircuitDag> _dag;
+    std::optional<std::vector<bool>> _liveness;
+    std::optional<std::vector<std::size_t>> _gate_counts;
+    std::optional<std::size_t> _gate_total;
+};
+
+struct Pass {
+    std::string name;
+    std::string description;
+    /// @brief Runs the pass and returns the analyses it changed.
+    std::function<Analyses(IR&, AnalysisCache&)> run;
+};
+
+/// @brief Settings of the builtin passes.
+struct PassOptions {
+    UnrollOptions unroll;
+};
+
+class PassManager {
+public:
+    /// @brief A manager knowing the builtin passes.
+    explicit PassManager(const PassOptions& options = {});
+
+    /// @throws std::logic_error if a pass of that name is already registered.
+    void registerPass(Pass pass);
+    bool hasPass(std::string_view name) const;
+    const std::vector<Pass>& registeredPasses() const { return _passes; }
+
+    /**
+     * @brief Parses a comma separated pipeline, e.g. "decompose-mcx,merge-registers".
+     * @throws std::invalid_argument on an empty or unknown pass name.
+     */
+    std::vector<std::string> parsePipeline(std::string_view pipeline) const;
+
+    /**
+     * @brief Runs the passes in order. With report set, prints each pass's
+     *        wall time and the IR size before and after to it.
+     * @throws std::runtime_error naming the failed pass.
+     */
+    void run(IR& ir, const std::vector<std::string>& pipeline, std::ostream* report = nullptr) const;
+
+private:
+    std::vector<Pass> _passes;
+
+    const Pass& find(std::string_view name) const;
+};
+
+} // namespace passes
+
+/* EOF PassManager.hpp */
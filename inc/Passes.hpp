@@ -1,20 +1,51 @@
 #pragma once
 #include "ir.hpp"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class CircuitDag;
 
 namespace passes {
 
+struct UnrollOptions {
+    std::size_t budget = 1'000'000;   // gates all unrolled loops may emit together
+    unsigned factor = 0;              // 0 unrolls fully, k >= 2 keeps loops with k body copies
+};
+
+struct UnrollStats {
+    std::size_t unrolled_loops = 0;
+    std::size_t emitted_gates = 0;
+    std::vector<std::string> kept_loops;   // why a loop stayed, one line each
+};
+
 /**
- * @brief Unrolls all LoopApplication nodes in the IR whose iteration count is a compile-time constant.
+ * @brief Unrolls all LoopApplication nodes in the IR whose iteration values are compile-time constants.
+ *
+ * The loop variable is substituted into qubit indices, gate parameters, nested loop bounds and
+ * conditions. With a factor k, an interval loop of n > k iterations is kept with k copies of its
+ * body per iteration, followed by the remaining n % k iterations unrolled.
+ *
+ * A loop is kept if its values are not constant, it declares variables, a non-integer value would
+ * end up in a qubit index, or unrolling it would exceed the budget; the stats say why. Unrolled
+ * gates are packed into GateStreams again.
+ *
  * @param ir The IR context to modify
  */
-void unrollLoops(IR& ir);
+UnrollStats unrollLoops(IR& ir, const UnrollOptions& options = {});
 
 /**
  * @brief Inlines all CompositeGate bodies at their call sites, replacing composite gate applications
  *        with the sequence of atomic gate applications they are defined as.
+ *
+ * Each composite gate is flattened once (see inline.hpp); a call site only instantiates the
+ * flattened body with its operands and parameters. Calls in loop and conditional bodies,
+ * GateStreams and subroutine bodies are inlined too; the composite gates end up unused.
+ *
  * @param ir The IR context to modify
+ * @return The number of calls inlined
  */
-void inlineCompositeGates(IR& ir);
+std::size_t inlineCompositeGates(IR& ir);
 
 /**
  * @brief Decomposes all MCX gates in the IR into chains of X, CX, and CCX gates using the standard V-chain decomposition.
@@ -25,17 +56,58 @@ void inlineCompositeGates(IR& ir);
  */
 void decomposeMCX(IR& ir);
 
+/**
+ * @brief Removes pairs of mutually inverse gates (x x, cx a,b cx a,b, h h, s sdg, t tdg, ...)
+ *        that are adjacent on all their qubits; gates on other qubits may sit in between.
+ *
+ * Works on the CircuitDag of each block (loop and conditional bodies separately), sweeping it
+ * in program order until no pair is left, so nested pairs such as x h h x go as well.
+ * Only parameterless atomic gates are cancelled.
+ *
+ * @param ir The IR context to modify
+ * @return The number of gates removed
+ */
+std::size_t cancelInversePairs(IR& ir);
+/// @brief Same, with dag a view of the global block (e.g. a cached analysis); committed if anything is removed there.
+std::size_t cancelInversePairs(IR& ir, CircuitDag& dag);
+
+/**
+ * @brief Fuses rx, ry and rz rotations of the same axis on the same qubit into one rotation by the
+ *        sum of their angles, also across gates commuting with them in between (diagonal gates and
+ *        controls for rz, x and cx targets for rx, y and cy targets for ry).
+ *
+ * Numeric angles are added, others are summed as text ("a+b"). Rotations by a multiple of 4*pi,
+ * e.g. rz(a) rz(-a), are removed. Works on the CircuitDag of each block like cancelInversePairs;
+ * in loop bodies rotations on the same non-literal qubit (q[i] and q[i]) are fused as well.
+ *
+ * @param ir The IR context to modify
+ * @return The number of gates removed
+ */
+std::size_t mergeRotations(IR& ir);
+/// @brief Same, with dag a view of the global block (e.g. a cached analysis); committed if anything is removed there.
+std::size_t mergeRotations(IR& ir, CircuitDag& dag);
+
 /**
  * @brief Merges registers into one register when possible to reduce the total number of registers used.
  * 
  * @param ir The IR context to modify
  * 
  * @warning This pass will merge all Nonparametric qubit registers with constant integer sizes into a 
- *          single register named "__merged_qubits" and rename the merged registers "__unused" with size "0".
- *          Should be skipped during emitting.
+ *          single register named "__merged_qubits" and remove the merged registers.
  */
 void mergeRegisters(IR& ir);
 
+/**
+ * @brief Packs long runs of gate applications with literal qubit indices in the
+ *        program (including loop and conditional bodies) into GateStream nodes.
+ *
+ * @note Run right after the IR is built, so that the other passes and the
+ *       printers already iterate the packed arrays.
+ *
+ * @param ir The IR context to modify
+ */
+void packGateStreams(IR& ir);
+
 /**
  * @brief Evaluates all gate parameter expressions to their double-precision floating point values.
  *
@@ -6,11 +6,15 @@
  * Semantics from: https://openqasm.com/language/scope.html
  */
 #pragma once
+#include <cstdint>
+#include <deque>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 #include <variant>
 #include "ir.hpp"
+#include "Interner.hpp"
 
 enum class ScopeKind {
     Global,
@@ -31,7 +35,7 @@ enum class SymbolKind {
 };
 
 struct Symbol {
-    std::string name;
+    InternedName name;
     SymbolKind kind;
 
     std::variant<std::monostate, size_t, std::string> ir_ref;
@@ -39,9 +43,18 @@ struct Symbol {
     std::vector<std::string> aliases;
 };
 
+/**
+ * Symbols of all open scopes live in one flat table: every name maps to its
+ * innermost binding, and each binding links to the one it shadows. The
+ * bindings form a stack that doubles as the undo log, so leaving a scope
+ * pops the bindings it made and restores the shadowed ones, O(k) for k local
+ * symbols, and no scope allocates a table of its own.
+ */
 struct Scope {
     ScopeKind kind;
-    std::unordered_map<std::string, Symbol> symbols;
+    std::uint32_t first_binding;    // bindings made in this scope start here
+    std::uint32_t first_symbol;
+    std::uint32_t gate_scope;       // innermost GateOrSubroutine scope, NONE if outside
 };
 
 class ScopeManager {
@@ -56,12 +69,34 @@ public:
 
     void addSymbol(const Symbol& symbol);
 
-    const Symbol* lookupSymbol(const std::string& name) const;
+    /// @brief Innermost visible symbol of that name, nullptr if none; hashes the text once.
+    const Symbol* lookupSymbol(std::string_view name) const;
+    const Symbol* lookupSymbol(SymbolId name) const;
+
+    /// @brief Symbols of all open scopes in the order they were added.
+    std::size_t symbolCount() const { return _symbols.size(); }
+    const Symbol& symbol(std::size_t index) const { return _symbols[index]; }
 
 private:
+    static constexpr std::uint32_t NONE = static_cast<std::uint32_t>(-1);
+
+    struct Binding {
+        SymbolId name;
+        std::uint32_t symbol;       // index into _symbols
+        std::uint32_t scope;        // index into _scopes
+        std::uint32_t shadowed;     // previous binding of name, NONE if none
+    };
+
     std::vector<Scope> _scopes;
+    std::deque<Symbol> _symbols;    // aliases share the canonical symbol
+    std::vector<Binding> _bindings;
+    std::vector<std::uint32_t> _innermost;   // by SymbolId (ids are dense), NONE if unbound
+    // text of every name bound so far (views into the interner), so a lookup
+    // by text hashes it once without taking the interner's lock
+    std::unordered_map<std::string_view, SymbolId> _local_ids;
+
+    void bind(SymbolId name, std::uint32_t symbol);
 
     bool isVisibleFromGateOrSubroutineScope(const Symbol& sym) const;
 
 };
-
@@ -0,0 +1,66 @@
+/**
+ * @file Serialize.hpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ *
+ * Little-endian binary encoding shared by the on-disk formats (precompiled
+ * gate libraries). Writer appends to a byte string, Reader decodes from a
+ * byte view (typically a mapped file) and throws on truncated input.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace serialize {
+
+class Writer {
+public:
+    void u8(std::uint8_t value);
+    void u32(std::uint32_t value);
+    void u64(std::uint64_t value);
+    void i64(std::int64_t value);
+    void string(std::string_view value);
+    void strings(const std::vector<std::string>& values);
+    void raw(std::string_view bytes);
+
+    const std::string& bytes() const { return _bytes; }
+
+private:
+    std::string _bytes;
+};
+
+class Reader {
+public:
+    explicit Reader(std::string_view bytes) : _bytes(bytes) {}
+
+    std::uint8_t u8();
+    std::uint32_t u32();
+    std::uint64_t u64();
+    std::int64_t i64();
+    std::string string();
+    std::vector<std::string> strings();
+    std::string_view raw(std::size_t size);
+
+    bool atEnd() const { return _pos == _bytes.size(); }
+
+private:
+    const char* take(std::size_t size);
+
+    std::string_view _bytes;
+    std::size_t _pos = 0;
+};
+
+/**
+ * @brief Writes bytes to path through a temporary file and a rename, so
+ *        concurrent readers never see a partial file.
+ * @return false if the file could not be written (e.g. read-only directory).
+ */
+bool writeFileAtomically(const std::string& path, std::string_view bytes);
+
+} // namespace serialize
+
+/* EOF Serialize.hpp */
@@ -0,0 +1,245 @@
+/**
+ * @file SlotMap.hpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ *
+ * Generational slot map: the storage of registers, gates and subroutines.
+ *
+ * An id is a slot index in its low 32 bits and the slot's generation in the
+ * high bits. Insertion and removal are O(1) and never move other entries'
+ * ids; a removed slot is reused by a later insertion under the next
+ * generation, so a stale id is rejected instead of silently naming the new
+ * entry. Iteration visits live entries only, in slot order.
+ *
+ * Until something is removed every id equals its slot index, so a freshly
+ * built IR has the dense ids 0, 1, 2, ... Per-id side tables are indexed by
+ * slotIndex(id) and sized by slotCount().
+ *
+ * filter() gives a read-only view of the entries matching a predicate,
+ * evaluated lazily during iteration; nothing is copied.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+inline constexpr std::size_t slotIndex(std::size_t id) {
+    return id & 0xFFFF'FFFFu;
+}
+
+template <typename T>
+class SlotMap {
+public:
+    using Id = std::size_t;
+
+    template <bool Const>
+    class Iterator {
+    public:
+        using SlotVector = std::conditional_t<Const, const std::vector<std::optional<T>>, std::vector<std::optional<T>>>;
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::conditional_t<Const, const T&, T&>;
+        using pointer = std::conditional_t<Const, const T*, T*>;
+
+        Iterator() = default;
+        Iterator(const SlotMap* map, SlotVector* values, std::size_t index)
+            : _map(map), _values(values), _index(index) { skipDead(); }
+
+        reference operator*() const { return *(*_values)[_index]; }
+        pointer operator->() const { return &*(*_values)[_index]; }
+
+        /// @brief Id of the current entry.
+        Id id() const { return _map->makeId(_index); }
+
+        Iterator& operator++() {
+            ++_index;
+            skipDead();
+            return *this;
+        }
+        Iterator operator++(int) {
+            auto copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        bool operator==(const Iterator& other) const { return _index == other._index; }
+
+    private:
+        const SlotMap* _map = nullptr;
+        SlotVector* _values = nullptr;
+        std::size_t _index = 0;
+
+        void skipDead() {
+            while (_index < _values->size() && !(*_values)[_index]) {
+                ++_index;
+            }
+        }
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    /// @brief Live entries for which pred holds. Must not outlive the map, nor
+    ///        its iterators the view.
+    template <typename Pred>
+    class FilterView {
+    public:
+        class iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using reference = const T&;
+            using pointer = const T*;
+
+            iterator() = default;
+            iterator(const_iterator it, const_iterator end, const Pred* pred)
+                : _it(it), _end(end), _pred(pred) { skipRejected(); }
+
+            reference operator*() const { return *_it; }
+            pointer operator->() const { return _it.operator->(); }
+            Id id() const { return _it.id(); }
+
+            iterator& operator++() {
+                ++_it;
+                skipRejected();
+                return *this;
+            }
+            iterator operator++(int) {
+                auto copy = *this;
+                ++*this;
+                return copy;
+            }
+
+            bool operator==(const iterator& other) const { return _it == other._it; }
+
+        private:
+            const_iterator _it;
+            const_iterator _end;
+            const Pred* _pred = nullptr;
+
+            void skipRejected() {
+                while (_it != _end && !(*_pred)(*_it)) {
+                    ++_it;
+                }
+            }
+        };
+
+        FilterView(const SlotMap* map, Pred pred) : _map(map), _pred(std::move(pred)) {}
+
+        iterator begin() const { return iterator(_map->begin(), _map->end(), &_pred); }
+        iterator end() const { return iterator(_map->end(), _map->end(), &_pred); }
+
+    private:
+        const SlotMap* _map;
+        Pred _pred;
+    };
+
+    Id insert(T value) {
+        std::size_t index;
+        if (!_free.empty()) {
+            index = _free.back();
+            _free.pop_back();
+            _values[index].emplace(std::move(value));
+        } else {
+            index = _values.size();
+            if (index > 0xFFFF'FFFFu) {
+                throw std::length_error("Slot map is full");
+            }
+            _values.emplace_back(std::move(value));
+            _generations.push_back(0);
+        }
+        ++_size;
+        return makeId(index);
+    }
+
+    /**
+     * @brief Inserts value under a given id, e.g. one read back from a
+     *        snapshot. Skipped slots stay free for later insertions.
+     * @throws std::logic_error if the slot of id is in use.
+     */
+    void insertAt(Id id, T value) {
+        const std::size_t index = slotIndex(id);
+        while (_values.size() <= index) {
+            _free.push_back(_values.size());
+            _values.emplace_back();
+            _generations.push_back(0);
+        }
+        if (_values[index]) {
+            throw std::logic_error("Slot already in use");
+        }
+        std::erase(_free, index);
+        _generations[index] = static_cast<std::uint32_t>(id >> 32);
+        _values[index].emplace(std::move(value));
+        ++_size;
+    }
+
+    /// @throws std::out_of_range if id is not live.
+    void erase(Id id) {
+        checkLive(id);
+        const std::size_t index = slotIndex(id);
+        _values[index].reset();
+        ++_generations[index];
+        _free.push_back(index);
+        --_size;
+    }
+
+    bool contains(Id id) const {
+        const std::size_t index = slotIndex(id);
+        return index < _values.size() && _values[index] && _generations[index] == (id >> 32);
+    }
+
+    /// @throws std::out_of_range if id is not live.
+    T& at(Id id) {
+        checkLive(id);
+        return *_values[slotIndex(id)];
+    }
+    const T& at(Id id) const {
+        checkLive(id);
+        return *_values[slotIndex(id)];
+    }
+
+    /// @brief Unchecked access, id must be live.
+    T& operator[](Id id) { return *_values[slotIndex(id)]; }
+    const T& operator[](Id id) const { return *_values[slotIndex(id)]; }
+
+    /// @brief Number of live entries.
+    std::size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    /// @brief Upper bound of slotIndex() over all ids, live or not.
+    std::size_t slotCount() const { return _values.size(); }
+
+    iterator begin() { return iterator(this, &_values, 0); }
+    iterator end() { return iterator(this, &_values, _values.size()); }
+    const_iterator begin() const { return const_iterator(this, &_values, 0); }
+    const_iterator end() const { return const_iterator(this, &_values, _values.size()); }
+
+    template <typename Pred>
+    FilterView<Pred> filter(Pred pred) const { return FilterView<Pred>(this, std::move(pred)); }
+
+private:
+    std::vector<std::optional<T>> _values;
+    std::vector<std::uint32_t> _generations;
+    std::vector<std::size_t> _free;    // reused last in, first out
+    std::size_t _size = 0;
+
+    Id makeId(std::size_t index) const {
+        return static_cast<Id>(_generations[index]) << 32 | index;
+    }
+
+    void checkLive(Id id) const {
+        if (!contains(id)) {
+            throw std::out_of_range("Stale or invalid id");
+        }
+    }
+};
+
+/* EOF SlotMap.hpp */
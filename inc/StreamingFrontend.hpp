@@ -0,0 +1,109 @@
+/**
+ * @file StreamingFrontend.hpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ *
+ * Statement-at-a-time frontend with memory bounded by the largest statement.
+ *
+ * The regular frontend buffers every token, builds the parse tree of the
+ * whole program and walks it twice before anything is printed. Here the
+ * tokens come through an UnbufferedTokenStream, each top-level statement is
+ * parsed on its own, lowered by the usual collectors and handed to a
+ * streaming printer, after which its parse tree, tokens and IR nodes are
+ * freed. Only declarations (registers, gates, subroutines, constants) stay
+ * in the IR.
+ *
+ * OpenQASM requires gates and registers to be declared before they are used,
+ * so a single pass over the statements sees every declaration in time.
+ */
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <antlr4-runtime/antlr4-runtime.h>
+#include "qasm3Lexer.h"
+#include "qasm3Parser.h"
+#include "Frontend.hpp"
+#include "MappedCharStream.hpp"
+#include "ScopeManager.hpp"
+#include "ir.hpp"
+#include "printers/Printer.hpp"
+
+namespace frontend {
+
+/**
+ * @brief Parses a token source one top-level statement at a time.
+ *
+ * Each statement is parsed with SLL prediction first; on a syntax error the
+ * stream is rewound to the start of the statement and it is parsed again
+ * with full LL prediction and the default error reporting (the same two
+ * stages as parseTwoStage, applied per statement). The tokens of the current
+ * statement are kept buffered until the next call.
+ */
+class StatementStream {
+public:
+    explicit StatementStream(antlr4::TokenSource& source);
+    ~StatementStream();
+
+    StatementStream(const StatementStream&) = delete;
+    StatementStream& operator=(const StatementStream&) = delete;
+
+    /**
+     * @brief Frees the previous statement and parses the next one.
+     * @return The statement's parse tree, or nullptr at the end of input.
+     *         A leading version statement is consumed and skipped.
+     */
+    qasm3Parser::StatementOrScopeContext* next();
+
+    /// @brief Stream index of the first character not needed anymore.
+    size_t consumedCharIndex();
+
+    size_t statements() const { return _statements; }
+    size_t llFallbacks() const { return _ll_fallbacks; }
+
+private:
+    class Parser;
+
+    template <typename Rule>
+    auto parseStatement(Rule rule);
+
+    void releaseStatement();
+    void useSLL();
+    void useLL();
+
+    antlr4::UnbufferedTokenStream _tokens;
+    std::unique_ptr<Parser> _parser;
+    std::shared_ptr<antlr4::ANTLRErrorStrategy> _bail;
+    std::shared_ptr<antlr4::DefaultErrorStrategy> _recover;
+
+    ssize_t _marker = 0;
+    bool _marked = false;
+    bool _at_start = true;
+    bool _in_ll = false;
+
+    size_t _statements = 0;
+    size_t _ll_fallbacks = 0;
+};
+
+struct StreamStats {
+    size_t statements = 0;
+    size_t ll_fallbacks = 0;  // statements re-parsed with LL prediction
+    size_t nodes = 0;         // top-level IR nodes printed
+};
+
+/**
+ * @brief Parses, lowers and prints the input one statement at a time.
+ *
+ * The IR and scopes must already hold the builtin gates. Consumed input
+ * pages are handed back to the kernel as the stream advances.
+ *
+ * @throws std::runtime_error on semantic errors (unknown gate, register...)
+ *         and when the printer does not support streaming.
+ */
+StreamStats streamProgram(MappedCharStream& input, IR& ir, ScopeManager& scopes,
+                          Printer& printer, std::ostream& out);
+
+} // namespace frontend
+
+/* EOF StreamingFrontend.hpp */
@@ -0,0 +1,105 @@
+/**
+ * @file inline.hpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ *
+ * Composite gate inlining - flattened bodies of composite gates and their
+ * instantiation at call sites.
+ *
+ * A composite gate is flattened once into the sequence of atomic gates it
+ * stands for: nested composites are expanded with their own flattened
+ * bodies, repeat blocks are repeated. Each atomic gate refers to its qubits
+ * by argument position and keeps its parameters as text split at the
+ * composite's parameter names, so a call site only picks its operands and
+ * joins parameter text; the body tree is not walked again.
+ */
+#pragma once
+
+#include "ir.hpp"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// @brief Parameter text of a flattened gate: literal pieces and references to the caller's parameters.
+struct ParamTemplate {
+    static constexpr std::size_t LITERAL = static_cast<std::size_t>(-1);
+
+    struct Piece {
+        std::string text;                   // for literal pieces
+        std::size_t parameter = LITERAL;    // index into the call's params otherwise
+    };
+    std::vector<Piece> pieces;
+
+    /// @brief Splits text at the names in parameter_index.
+    static ParamTemplate parse(std::string_view text,
+                               const std::unordered_map<std::string, std::size_t>& parameter_index);
+
+    /// @brief The text with the parameters replaced by the given values.
+    template <typename Strings>
+    std::string instantiate(const Strings& params) const;
+};
+
+/// @brief One atomic gate of a flattened composite gate.
+struct FlatGate {
+    idGate gate_id;
+    std::vector<std::size_t> inputs;     // argument positions of the composite
+    std::vector<ParamTemplate> params;
+};
+
+/**
+ * Flattened composite gates of one IR, built on first use. Must be cleared
+ * when gates of the IR change.
+ */
+class CompositeTemplates {
+public:
+    /**
+     * @brief The atomic gates composite gate id stands for.
+     * @throws std::runtime_error on a gate that contains itself or a call
+     *         with more qubits or parameters than its gate takes.
+     */
+    const std::vector<FlatGate>& flatten(const IR& ir, idGate id);
+
+    /// @brief Gate flat of a call to its composite gate, as a stand-alone application.
+    static void instantiate(const FlatGate& flat, const GateApplication& call, GateApplication& out);
+
+    void clear();
+
+private:
+    struct Entry {
+        bool building = false;
+        bool built = false;
+        std::vector<FlatGate> gates;
+    };
+    std::vector<Entry> _entries;   // by slotIndex(id)
+
+    void flattenBody(const IR& ir, const GateDef& gate, const std::vector<GateStmt>& body,
+                     std::vector<FlatGate>& out);
+};
+
+template <typename Strings>
+std::string ParamTemplate::instantiate(const Strings& params) const {
+    if (pieces.size() == 1 && pieces[0].parameter == LITERAL) {
+        return pieces[0].text;
+    }
+    std::string text;
+    for (const auto& piece : pieces) {
+        if (piece.parameter == LITERAL) {
+            text += piece.text;
+            continue;
+        }
+        const std::string_view value = params[piece.parameter];
+        // an expression argument keeps its precedence, e.g. theta/2 with theta = a+b
+        const bool simple = value.find_first_of("+-*/^% ") == std::string_view::npos;
+        if (simple) {
+            text += value;
+        } else {
+            text += '(';
+            text += value;
+            text += ')';
+        }
+    }
+    return text;
+}
+
+/* EOF inline.hpp */
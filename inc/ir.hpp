@@ -15,11 +15,19 @@
 #include <vector>
 #include <unordered_map>
 #include <cstddef>
+#include <cstdint>
+#include <utility>
 #include <variant>
 #include <memory>
+#include <memory_resource>
 #include <optional>
+#include <functional>
+#include <string_view>
 
 #include "matrix.hpp"
+#include "Interner.hpp"
+#include "Arena.hpp"
+#include "SlotMap.hpp"
 
 using ACN = AlgebraicComplexNumber<DenseNumberStore>;
 
@@ -45,22 +53,55 @@ enum class RegisterType {
 };
 
 struct RegisterDef {
-    std::string name;
+    InternedName name;
     RegisterKind kind;
     RegisterType type;
     std::string size;
 };
 
-struct RegisterRef {
-    idRegister reg_id;
-    std::string qubit_index;
+/**
+ * Index of a qubit in a register: scale * symbol + offset, or just offset
+ * when there is no symbol (a literal). Indices that are not affine in a
+ * single variable keep their source text in opaque and are printed as is.
+ */
+struct IndexExpr {
+    std::ptrdiff_t scale = 0;
+    std::optional<SymbolId> symbol;   // e.g., loop variable i
+    std::ptrdiff_t offset = 0;        // e.g., 2*i-1 -> scale=2, offset=-1
+    std::string opaque;               // non-empty for non-affine indices
+
+    static IndexExpr literal(std::ptrdiff_t value);
+
+    bool isLiteral() const { return !symbol && opaque.empty(); }
+    bool isAffine() const { return opaque.empty(); }
+
+    /// @brief Value of the index for symbol = value; affine indices only.
+    std::ptrdiff_t evaluate(std::ptrdiff_t value) const { return scale * value + offset; }
+
+    /// @brief Moves the index by shift, e.g., when registers are merged.
+    void shift(std::ptrdiff_t by);
+
+    /// @brief OpenQASM source form, e.g., "3", "i", "2*i-1".
+    std::string str() const;
+
+    bool operator==(const IndexExpr& other) const = default;
 };
 
-struct IndexExpr {
-    bool is_constant;               // true if constant
-    std::ptrdiff_t constant_value;  // valid if is_constant
-    std::string symbol;             // e.g., "n", valid if !is_constant
-    std::ptrdiff_t offset;          // e.g., n-2 -> symbol="n", offset=-2
+/**
+ * @brief Parses the text of an index expression into an IndexExpr.
+ *
+ * Integer literals, identifiers, unary minus, +, -, * and parentheses are
+ * folded into affine form; anything else becomes an opaque index.
+ *
+ * @param constant Value of an identifier known at compile time (e.g., a
+ *        const with a literal initializer), or nullopt for a variable.
+ */
+IndexExpr parseIndexExpr(std::string_view text,
+    const std::function<std::optional<std::ptrdiff_t>(std::string_view)>& constant = {});
+
+struct RegisterRef {
+    idRegister reg_id;
+    IndexExpr index;
 };
 
 enum class GateKind {
@@ -102,7 +143,7 @@ struct CompositeGateBody {
 };
 
 struct GateDef {
-    std::string name;
+    InternedName name;
     std::vector<std::string> aliases;
 
     std::vector<std::string> argument_qubits;
@@ -119,11 +160,44 @@ struct ProgramNodeBase;
 struct GateApplication;
 struct LoopApplication;
 struct ConditionalApplication;
+struct GateStream;
 struct VariableDef;
 
+/**
+ * Program nodes are a closed set tagged by NodeKind. Traversals switch on
+ * the tag (or use node_cast) instead of dynamic_cast, and nodes carry no
+ * vtable: NodeDeleter destroys them through the tag as well.
+ *
+ * Nodes live in an Arena (normally IR::arena()), which owns their memory;
+ * NodeDeleter only runs the destructor.
+ */
+enum class NodeKind : std::uint8_t {
+    Gate,
+    Loop,
+    Conditional,
+    Stream
+};
+
+struct NodeDeleter {
+    void operator()(ProgramNodeBase* node) const;
+};
 
+template <typename T>
+using NodePtr = std::unique_ptr<T, NodeDeleter>;
 
-using ProgramNodePtr = std::unique_ptr<ProgramNodeBase>;
+using ProgramNodePtr = NodePtr<ProgramNodeBase>;
+
+/**
+ * @brief Constructs a program node in arena. Nodes with an allocator_type
+ *        get the arena for their operand and parameter arrays as well.
+ */
+template <typename T, typename... Args>
+NodePtr<T> makeNode(Arena& arena, Args&&... args) {
+    std::pmr::polymorphic_allocator<T> alloc(arena.resource());
+    T* node = alloc.allocate(1);
+    std::uninitialized_construct_using_allocator(node, alloc, std::forward<Args>(args)...);
+    return NodePtr<T>(node);
+}
 
 struct Block {
     std::vector<VariableDef> variables;   // declared here only
@@ -131,13 +205,48 @@ struct Block {
 };
 
 struct ProgramNodeBase {
-    virtual ~ProgramNodeBase() = default;
+    NodeKind kind;
+
+protected:
+    explicit ProgramNodeBase(NodeKind kind) : kind(kind) {}
+    ~ProgramNodeBase() = default;   // not virtual, see NodeDeleter
 };
 
+/// @brief Downcast by tag; nullptr if node is not a T.
+template <typename T>
+T* node_cast(ProgramNodeBase* node) {
+    return node && node->kind == T::KIND ? static_cast<T*>(node) : nullptr;
+}
+
+template <typename T>
+const T* node_cast(const ProgramNodeBase* node) {
+    return node && node->kind == T::KIND ? static_cast<const T*>(node) : nullptr;
+}
+
 struct GateApplication : ProgramNodeBase {
+    static constexpr NodeKind KIND = NodeKind::Gate;
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    GateApplication() : GateApplication(allocator_type{}) {}
+    explicit GateApplication(const allocator_type& alloc)
+        : ProgramNodeBase(KIND), operands(alloc), params(alloc) {}
+
+    GateApplication(const GateApplication&) = default;
+    GateApplication(GateApplication&&) noexcept = default;
+    GateApplication& operator=(const GateApplication&) = default;
+    GateApplication& operator=(GateApplication&&) = default;
+
+    // copies into alloc, e.g. when a node built on the heap moves into an arena
+    GateApplication(const GateApplication& other, const allocator_type& alloc)
+        : ProgramNodeBase(KIND), gate_id(other.gate_id),
+          operands(other.operands, alloc), params(other.params, alloc) {}
+    GateApplication(GateApplication&& other, const allocator_type& alloc)
+        : ProgramNodeBase(KIND), gate_id(other.gate_id),
+          operands(std::move(other.operands), alloc), params(std::move(other.params), alloc) {}
+
     idGate gate_id;
-    std::vector<RegisterRef> operands;
-    std::vector<std::string> params; // for parametric gates, e.g. RZ(phi)
+    std::pmr::vector<RegisterRef> operands;
+    std::pmr::vector<std::pmr::string> params; // for parametric gates, e.g. RZ(phi)
 };
 
 struct Interval {
@@ -153,6 +262,9 @@ using LoopValues = std::variant<
 >;
 
 struct LoopApplication : ProgramNodeBase {
+    static constexpr NodeKind KIND = NodeKind::Loop;
+    LoopApplication() : ProgramNodeBase(KIND) {}
+
     // for uint i in [0:n-2]
 
     // for int[32] j in {1, 5, 10}
@@ -166,11 +278,52 @@ struct LoopApplication : ProgramNodeBase {
 };
 
 struct ConditionalApplication : ProgramNodeBase {
+    static constexpr NodeKind KIND = NodeKind::Conditional;
+    ConditionalApplication() : ProgramNodeBase(KIND) {}
+
     std::string condition_expr;           
     std::vector<ProgramNodePtr> then_body;
     std::vector<ProgramNodePtr> else_body;
 };
 
+/**
+ * Straight-line run of gate applications with literal qubit indices, stored
+ * as parallel arrays instead of one GateApplication per gate. Gate i applies
+ * gates[i] to the qubits operand_regs[j][operand_indices[j]] for j in
+ * [operand_offsets[i], operand_offsets[i + 1]), with the parameters
+ * params[param_offsets[i] .. param_offsets[i + 1]).
+ *
+ * Built by passes::packGateStreams; passes and printers with a hot loop over
+ * gates walk the arrays directly, the others unpack gates one by one.
+ */
+struct GateStream : ProgramNodeBase {
+    static constexpr NodeKind KIND = NodeKind::Stream;
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    GateStream() : GateStream(allocator_type{}) {}
+    explicit GateStream(const allocator_type& alloc)
+        : ProgramNodeBase(KIND), gates(alloc), operand_offsets(1, 0, alloc),
+          operand_regs(alloc), operand_indices(alloc), param_offsets(1, 0, alloc), params(alloc) {}
+
+    std::pmr::vector<std::uint32_t> gates;            // gate id opcodes
+    std::pmr::vector<std::uint32_t> operand_offsets;  // size() + 1 entries
+    std::pmr::vector<std::uint32_t> operand_regs;
+    std::pmr::vector<std::int32_t> operand_indices;
+    std::pmr::vector<std::uint32_t> param_offsets;    // size() + 1 entries
+    std::pmr::vector<std::pmr::string> params;        // angle table
+
+    std::size_t size() const { return gates.size(); }
+
+    /// @brief Whether app can be stored, i.e. all its qubit indices are literals.
+    static bool accepts(const GateApplication& app);
+    void append(const GateApplication& app);
+    /// @brief Copies gate i of other to the end of this stream.
+    void append(const GateStream& other, std::size_t i);
+
+    /// @brief Gate i as a stand-alone GateApplication.
+    GateApplication unpack(std::size_t i) const;
+};
+
 // struct SubroutineCall : ProgramNodeBase {
 //     std::string name;
 //     std::vector<std::string> arguments;
@@ -201,7 +354,7 @@ struct ParameterDef {
 // };
 
 struct SubroutineDef {
-    std::string name;
+    InternedName name;
     std::vector<ParameterDef> parameters;
     std::optional<std::string> return_type;
     Block body;
@@ -252,8 +405,19 @@ struct VariableDef {
 
 
 
+/**
+ * Registers, gates and subroutines are kept in slot maps (see SlotMap.hpp):
+ * ids stay valid while other entries are added or removed, and iterating
+ * getAllRegisters() etc. visits live entries only.
+ */
 class IR {
 public:
+    IR() = default;
+    IR(IR&&) = default;
+    /// @brief Frees the old program nodes before the arenas they live in.
+    IR& operator=(IR&& other) noexcept;
+    ~IR() = default;
+
     // Registers
     std::size_t addRegister(const RegisterDef& def);
     const RegisterDef& getRegister(std::size_t id) const;
@@ -261,9 +425,17 @@ public:
     RegisterDef& getRegister(std::size_t id);
     RegisterDef& getRegister(const std::string& name);
     const idRegister getRegisterId(std::string name) const;
-    const std::vector<RegisterDef> getAllRegisters() const;
+    const SlotMap<RegisterDef>& getAllRegisters() const;
+    /// @brief Live qubit registers; iterators expose id(), see SlotMap::filter().
+    auto qubitRegisters() const {
+        return registers.filter([](const RegisterDef& reg) { return reg.type == RegisterType::Qubit; });
+    }
+    std::size_t registerCount() const;
     bool hasRegister(const std::string& name) const;
     void removeRegister(std::size_t id);
+    void renameRegister(std::size_t id, const std::string& name);
+    /// @brief Adds def under a given id, e.g. one read back from a snapshot.
+    void addRegisterAt(std::size_t id, const RegisterDef& def);
 
     // Gates
     std::size_t addGate(const GateDef& def);
@@ -271,13 +443,20 @@ public:
     const GateDef& getGate(const std::string& name) const;
     GateDef& getGate(std::size_t id);
     GateDef& getGate(const std::string& name);
-    const std::vector<GateDef> getAllGates() const;
+    const SlotMap<GateDef>& getAllGates() const;
+    /// @brief Gates marked used, see markGateUsed().
+    auto usedGates() const {
+        return gates.filter([](const GateDef& gate) { return gate.used; });
+    }
+    std::size_t gateCount() const;
     const idGate getGateId(std::string name) const;
     bool hasGate(const std::string& name) const;
     void markGateUsed(const std::string& name);
     void markGateUsed(std::size_t id);
     void markGateUnused(const std::string& name);
     void markGateUnused(std::size_t id);
+    void removeGate(std::size_t id);
+    void addGateAt(std::size_t id, const GateDef& def);
 
 
     // Subroutines
@@ -286,29 +465,77 @@ public:
     const SubroutineDef& getSubroutine(const std::string& name) const;
     SubroutineDef& getSubroutine(std::size_t id);
     SubroutineDef& getSubroutine(const std::string& name);
-    const std::vector<SubroutineDef>& getAllSubroutines() const;
+    const SlotMap<SubroutineDef>& getAllSubroutines() const;
     const idGate getSubroutineId(std::string name) const;
     bool hasSubroutine(const std::string& name) const;
     void markSubroutineUsed(const std::string& name);
     void markSubroutineUsed(std::size_t id);
+    void removeSubroutine(std::size_t id);
+    void addSubroutineAt(std::size_t id, SubroutineDef&& def);
 
     int resolveLoopCount(const LoopValues& values) const;
 
     Block& getGlobalBlock();
     const Block& getGlobalBlock() const;
     const VariableDef& getGlobalVariable(const std::string& name) const;
+    /// @brief Compile-time value of a global const, nullopt if it has none.
+    std::optional<std::ptrdiff_t> getConstantValue(std::string_view name) const;
+
 
+    /// @brief Where the program nodes of this IR are allocated.
+    Arena& arena();
+    /// @brief Keeps nodes allocated in another arena (e.g. by a worker thread) alive.
+    void adoptArena(std::unique_ptr<Arena> arena);
 
 private:
-    std::vector<RegisterDef> registers;
-    std::vector<GateDef> gates;
-    std::vector<SubroutineDef> subroutines;
+    // the arenas must outlive global_block, which holds their nodes
+    std::unique_ptr<Arena> node_arena = std::make_unique<Arena>();
+    std::vector<std::unique_ptr<Arena>> adopted_arenas;
+
+    SlotMap<RegisterDef> registers;
+    SlotMap<GateDef> gates;
+    SlotMap<SubroutineDef> subroutines;
 
     Block global_block;
 
-    std::unordered_map<std::string, std::size_t> register_table;
-    std::unordered_map<std::string, std::size_t> gate_table;
-    std::unordered_map<std::string, std::size_t> subroutine_table;
+    // keyed by interned name, see Interner.hpp
+    using NameTable = std::unordered_map<SymbolId, std::size_t>;
+    NameTable register_table;
+    NameTable gate_table;
+    NameTable subroutine_table;
+
+    /// @brief The table entry of name, or end() if it was never interned.
+    static NameTable::const_iterator findName(const NameTable& table, const std::string& name);
+
+    void checkGateNames(const GateDef& def) const;
+    void bindGateNames(const GateDef& def, std::size_t id);
+};
+
+/**
+ * Flat qubit numbering: the qubit registers one after another in slot order,
+ * as the Stim and MOSF targets number them. Built once per print instead of
+ * looking registers up by name for every operand.
+ */
+class QubitLayout {
+public:
+    QubitLayout() = default;
+    /// @throws std::invalid_argument if a qubit register has a non-constant size.
+    explicit QubitLayout(const IR& ir);
+
+    /// @brief Appends the qubits of reg (a no-op for other registers), e.g. while streaming.
+    void add(idRegister id, const RegisterDef& reg);
+
+    bool contains(idRegister id) const;
+    /// @brief Number of qubit 0 of register id.
+    /// @throws std::out_of_range if id is not a qubit register of the layout.
+    std::size_t base(idRegister id) const;
+    std::size_t qubitCount() const { return _qubit_count; }
+
+private:
+    static constexpr std::size_t NONE = static_cast<std::size_t>(-1);
+
+    std::vector<std::size_t> _base;   // by slotIndex(id), NONE for other registers
+    std::size_t _qubit_count = 0;
 };
 
 /* EOF ir.hpp */
@@ -33,9 +33,9 @@ computeOffsets(const std::vector<std::pair<idRegister, std::size_t>>& regs);
 /**
  * Rewrites a single RegisterRef in-place.
  * If the ref's reg_id is in the offset map, updates reg_id to merged_id
- * and adjusts qubit_index by the offset.
- * Constant indices are resolved numerically.
- * Symbolic indices get "+ offset" appended as a string expression.
+ * and shifts its index by the offset.
+ * Affine indices get the offset added to their constant term.
+ * Opaque indices get "+offset" appended to their text.
  *
  * @param ref           RegisterRef to rewrite.
  * @param offset_map    Map from old reg_id to offset.
@@ -47,3 +47,12 @@ void rewriteRef(
     idRegister merged_id
 );
 
+/**
+ * Rewrites all operands of a GateStream in-place, like rewriteRef does for
+ * a single RegisterRef (stream indices are always literals).
+ */
+void rewriteStream(
+    GateStream& stream,
+    const std::unordered_map<idRegister, std::size_t>& offset_map,
+    idRegister merged_id
+);
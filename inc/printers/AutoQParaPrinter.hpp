@@ -39,7 +39,7 @@ public:
 
     void printRegister(const RegisterDef& reg, int indentLvl, std::ostream& out) const;
 
-    void printRegisterTable(const IR& ir, std::ostream& out) const;
+    void printRegisterTable(const IR& ir, std::ostream& out);
 
     void printGateStmt(const GateStmt& stmt, int indentLvl, const IR& ir, std::ostream& out) const;
 
@@ -57,6 +57,10 @@ public:
 
     void printLoopValues(const LoopApplication& loop, int indentLvl, std::ostream& out) const;
 
+    void printSingleGate(const GateApplication& gateApp, std::ostream& out) const;
+
+    void printLoopGate(const GateApplication& gate, std::ostream& out) const;
+
     void printTransducerDefs(const IR& ir, std::ostream& out) const;
 
     void printProgram(const IR& ir, std::ostream& out) const;
@@ -68,6 +72,8 @@ private:
 
     idGate getLocalGateId(idGate irGateId) const;
     idGate addLocalGateId(idGate irGateId);
+    idRegister getLocalRegisterId(idRegister irRegisterId) const;
 
     std::unordered_map<idGate, idGate> local_gates;
+    std::unordered_map<idRegister, idRegister> local_registers;
 };
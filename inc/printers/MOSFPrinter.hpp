@@ -37,13 +37,15 @@ public:
 
 private:
     //  Per-print mutable state (reset on each call to print()) 
-    std::unordered_map<std::string, int> qubit_levels; // varName --> BDD level
+    std::vector<std::string> level_vars; // BDD level --> varName
+    QubitLayout qubit_layout; // qubit register --> level of its qubit 0
     bool needs_high_swap = false; // set when CX with t-above-c is encountered
     int next_group_id = 0; // for generating unique group names when loop variable name is unavailable
 
     //  Level assignment 
     void        assignLevels(const IR& ir);
     std::string qubitVarName(const RegisterRef& ref, const IR& ir) const;
+    int         qubitLevel(const RegisterRef& ref) const;
 
     //  Top-level section builders 
     nlohmann::ordered_json buildVars() const;
@@ -64,7 +66,7 @@ private:
      * @param ir The IR for looking up gate and register details.
      * @return An ordered_json object representing the MOSF op tree for the given gate application
      */
-    nlohmann::ordered_json dispatchGate(GateApplication app, const IR& ir);
+    nlohmann::ordered_json dispatchGate(const GateApplication& app, const IR& ir);
 
     nlohmann::ordered_json dispatchCond(ConditionalApplication cond, const IR& ir);
 
@@ -77,7 +79,7 @@ private:
      * @param ir The IR for looking up gate and register details.
      * @return An ordered_json object representing the MOSF op tree for the MCX gate.
      */
-    nlohmann::ordered_json emitMCX(GateApplication app, const IR& ir);
+    nlohmann::ordered_json emitMCX(const GateApplication& app, const IR& ir);
 
     /**
      * @brief Emit an H gate as a MOSF op tree.
@@ -86,7 +88,7 @@ private:
      * @param ir The IR for looking up gate and register details.
      * @return An ordered_json object representing the MOSF op tree for the H gate.
      */
-    nlohmann::ordered_json emitH(GateApplication app, const IR& ir);
+    nlohmann::ordered_json emitH(const GateApplication& app, const IR& ir);
 
     /**
      * @brief Emit an RX gate as a MOSF op tree.
@@ -95,7 +97,7 @@ private:
      * @param ir The IR for looking up gate and register details.
      * @return An ordered_json object representing the MOSF op tree for the RX gate.
      */
-    nlohmann::ordered_json emitRX(GateApplication app, const IR& ir);
+    nlohmann::ordered_json emitRX(const GateApplication& app, const IR& ir);
 
     /**
      * @brief Emit an RY gate as a MOSF op tree.
@@ -104,7 +106,7 @@ private:
      * @param ir The IR for looking up gate and register details.
      * @return An ordered_json object representing the MOSF op tree for the RY gate
      */
-    nlohmann::ordered_json emitRY(GateApplication app, const IR& ir);
+    nlohmann::ordered_json emitRY(const GateApplication& app, const IR& ir);
 
     /**
      * @brief Emit an RZ gate as a MOSF op tree.
@@ -113,14 +115,14 @@ private:
      * @param ir The IR for looking up gate and register details.
      * @return An ordered_json object representing the MOSF op tree for the RZ gate
      */
-    nlohmann::ordered_json emitRZ(GateApplication app, const IR& ir);
-
-    nlohmann::ordered_json emitZ(GateApplication app, const IR& ir);
-    nlohmann::ordered_json emitS(GateApplication app, const IR& ir);
-    nlohmann::ordered_json emitY(GateApplication app, const IR& ir);
-    nlohmann::ordered_json emitT(GateApplication app, const IR& ir);
-    nlohmann::ordered_json emitCZ(GateApplication app, const IR& ir);
-    nlohmann::ordered_json emitTdg(GateApplication app, const IR& ir);
+    nlohmann::ordered_json emitRZ(const GateApplication& app, const IR& ir);
+
+    nlohmann::ordered_json emitZ(const GateApplication& app, const IR& ir);
+    nlohmann::ordered_json emitS(const GateApplication& app, const IR& ir);
+    nlohmann::ordered_json emitY(const GateApplication& app, const IR& ir);
+    nlohmann::ordered_json emitT(const GateApplication& app, const IR& ir);
+    nlohmann::ordered_json emitCZ(const GateApplication& app, const IR& ir);
+    nlohmann::ordered_json emitTdg(const GateApplication& app, const IR& ir);
 
 };
 
@@ -18,6 +18,11 @@ public:
 
     void print(const IR& ir, std::ostream& out) override;
 
+    bool supportsStreaming() const override { return true; }
+    void beginStream(std::ostream& out) override;
+    void streamRegister(const RegisterDef& reg, const IR& ir, std::ostream& out) override;
+    void streamNode(const ProgramNodeBase& node, const IR& ir, std::ostream& out) override;
+
     std::string name()        const override { return "OpenQASM." + std::to_string(version); }
     std::string extension()   const override { return "qasm"; }
     std::string description() const override { return "OpenQASM circuit format"; }
@@ -25,11 +30,13 @@ public:
 private:
     void printHeader(std::ostream& out);
     void printRegisters(const IR& ir, std::ostream& out);
+    void printRegister(const RegisterDef& reg, std::ostream& out);
     void printProgram(const IR& ir, std::ostream& out);
 
     void printBlock(const Block& block, const IR& ir, std::ostream& out, int depth);
     void printNode(const ProgramNodeBase& node, const IR& ir, std::ostream& out, int depth);
     void printGateApplication(const GateApplication& app, const IR& ir, std::ostream& out, int depth);
+    void printGateStream(const GateStream& stream, const IR& ir, std::ostream& out, int depth);
     void printLoopApplication(const LoopApplication& loop, const IR& ir, std::ostream& out, int depth);
     void printConditionalApplication(const ConditionalApplication& cond, const IR& ir, std::ostream& out, int depth);
 };
@@ -14,6 +14,16 @@ public:
     virtual ~Printer() = default;
 
     virtual void print(const IR& ir, std::ostream& out) = 0;
+
+    // Streaming output (see StreamingFrontend.hpp). The program is handed over
+    // one top-level node at a time and each node is freed right after; the IR
+    // passed along only holds declarations. Registers are announced as they
+    // are declared, always before the first node that uses them.
+    virtual bool supportsStreaming() const { return false; }
+    virtual void beginStream(std::ostream& /*out*/) {}
+    virtual void streamRegister(const RegisterDef& /*reg*/, const IR& /*ir*/, std::ostream& /*out*/) {}
+    virtual void streamNode(const ProgramNodeBase& /*node*/, const IR& /*ir*/, std::ostream& /*out*/) {}
+    virtual void endStream(const IR& /*ir*/, std::ostream& /*out*/) {}
     
     virtual std::string name() const = 0;
     virtual std::string extension() const = 0;
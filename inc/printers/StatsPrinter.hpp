@@ -8,6 +8,8 @@
 #include "Printer.hpp"
 #include <ostream>
 #include <stdexcept>
+#include <string>
+#include <unordered_map>
 
 class StatsPrinter : public Printer {
 public:
@@ -16,6 +18,11 @@ public:
 
     void print(const IR& ir, std::ostream& out) override;
 
+    bool supportsStreaming() const override { return true; }
+    void beginStream(std::ostream& out) override;
+    void streamNode(const ProgramNodeBase& node, const IR& ir, std::ostream& out) override;
+    void endStream(const IR& ir, std::ostream& out) override;
+
     std::string name()        const override { return "Stats."; }
     std::string extension()   const override { return "stats"; }
     std::string description() const override { return "Circuit statistics (gate counts, depth, etc.)"; }
@@ -23,9 +30,15 @@ private:
     void printHeader(std::ostream& out);
     void printRegisters(const IR& ir, std::ostream& out);
     void printGates(const IR& ir, std::ostream& out);
+    void printGateCounts(std::ostream& out,
+        const std::unordered_map<std::string, long long>& gate_counts);
     void printSubroutines(const IR& ir, std::ostream& out);
     void collectGateCallCounts(const Block& block, const IR& ir, 
         std::ostream& out, std::unordered_map<std::string, long long>& gate_counts, long long multiplier=1);
+    void collectNodeCallCounts(const ProgramNodeBase& node, const IR& ir,
+        std::ostream& out, std::unordered_map<std::string, long long>& gate_counts, long long multiplier=1);
+
+    std::unordered_map<std::string, long long> _streamed_counts;
 };
 
 /* EOF StatsPrinter.hpp */
\ No newline at end of file
@@ -6,6 +6,7 @@
 #pragma once
 #include "ir.hpp"
 #include "Printer.hpp"
+#include "inline.hpp"
 #include <ostream>
 #include <unordered_map>
 #include <vector>
@@ -13,6 +14,12 @@
 class StimPrinter : public Printer {
 public:
     void print(const IR& ir, std::ostream& out) override;
+
+    bool supportsStreaming() const override { return true; }
+    void beginStream(std::ostream& out) override;
+    void streamRegister(const RegisterDef& reg, const IR& ir, std::ostream& out) override;
+    void streamNode(const ProgramNodeBase& node, const IR& ir, std::ostream& out) override;
+    void endStream(const IR& ir, std::ostream& out) override;
     
     std::string name() const override { return "Stim"; }
     std::string extension() const override { return "stim"; }
@@ -21,18 +28,22 @@ public:
     }
 private:
 
+    size_t registerBase(idRegister reg_id, const IR& ir) const;
     size_t resolveQubit(const RegisterRef& ref, const IR& ir) const;
     void printAtomicGate(const GateApplication& app, const GateDef &gdef, const IR& ir, std::ostream& out);
     void printCompositeGate(const GateApplication& app, const GateDef &gdef, const IR& ir, std::ostream& out);
     void printGate(const GateApplication& app, const IR& ir, std::ostream& out);
+    void printGateStream(const GateStream& stream, const IR& ir, std::ostream& out);
     void printBlock(const Block& block, const IR& ir, std::ostream& out);
     void printProgramNode(const ProgramNodeBase& node, const IR& ir, std::ostream& out);
     
-    const std::unordered_map<std::string, std::string> _gate_map = {
-        {"h", "H"}, {"x", "X"}, {"y", "Y"}, {"z", "Z"},
-        {"s", "S"}, {"sdg", "S_DAG"}, 
-        {"cx", "CNOT"}, {"cz", "CZ"}, {"measure", "M"}
+    // keyed by interned gate names
+    const std::unordered_map<SymbolId, std::string> _gate_map = {
+        {intern("h"), "H"}, {intern("x"), "X"}, {intern("y"), "Y"}, {intern("z"), "Z"},
+        {intern("s"), "S"}, {intern("sdg"), "S_DAG"}, {intern("sx"), "SQRT_X"}, {intern("sxdg"), "SQRT_X_DAG"},
+        {intern("cx"), "CNOT"}, {intern("cy"), "CY"}, {intern("cz"), "CZ"}, {intern("measure"), "M"}
     };
     
-    std::unordered_map<std::string, size_t> _qubit_base;
+    QubitLayout _layout;
+    CompositeTemplates _composites;
 };
@@ -0,0 +1,90 @@
+/**
+ * @file unroll.hpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ *
+ * Loop unrolling pass - replaces loops with constant iteration values by
+ * copies of their body, the loop variable substituted into qubit indices,
+ * gate parameters, nested loop bounds and conditions.
+ *
+ * The program is walked once: a body is copied with all enclosing loop
+ * variables substituted at the same time, so nested loops are unrolled
+ * while their outer loop is, without copying or rewriting anything twice.
+ */
+#pragma once
+
+#include "Passes.hpp"
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// @brief One value a loop variable takes, with its integer value if it has one.
+struct IterationValue {
+    std::string text;
+    std::optional<std::ptrdiff_t> integer;
+};
+
+/**
+ * Values the loop variable takes, in order. Interval bounds and list
+ * elements may use global constants.
+ *
+ * @throws std::runtime_error with the reason if they are not known at
+ *         compile time (e.g. a loop over an array variable).
+ */
+std::vector<IterationValue> iterationValues(const LoopValues& values, const IR& ir);
+
+class LoopUnroller {
+public:
+    LoopUnroller(IR& ir, const passes::UnrollOptions& options);
+
+    /// @brief Unrolls the loops of the global block.
+    passes::UnrollStats run();
+
+private:
+    // what a loop variable stands for in the body being copied
+    struct Binding {
+        enum class Kind {
+            Value,   // one iteration value
+            Shift,   // the variable plus shift (partial unrolling)
+            Shadow   // itself, the loop is kept
+        };
+        SymbolId symbol;
+        const std::string* name;
+        Kind kind;
+        const IterationValue* value = nullptr;
+        std::ptrdiff_t shift = 0;
+    };
+
+    // thrown to abandon unrolling a loop, caught by the loop that keeps it
+    struct KeepLoop {
+        std::optional<SymbolId> variable;   // loop whose value does not fit, none for the budget
+        std::string reason;
+    };
+
+    IR& _ir;
+    passes::UnrollOptions _options;
+    passes::UnrollStats _stats;
+
+    std::vector<Binding> _bindings;   // enclosing loop variables, innermost last
+    std::size_t _unrolling = 0;       // loops being unrolled around the current node
+    std::size_t _remaining;           // gates the budget still allows
+
+    void rewrite(std::vector<ProgramNodePtr>& body);
+    void copyBody(const std::vector<ProgramNodePtr>& body, std::vector<ProgramNodePtr>& out);
+    void copyNode(const ProgramNodeBase& node, std::vector<ProgramNodePtr>& out);
+    void copyLoop(const LoopApplication& loop, std::vector<ProgramNodePtr>& out);
+    void keepLoop(const LoopApplication& loop, const std::string& reason, std::vector<ProgramNodePtr>& out);
+    void unrollLoop(const LoopApplication& loop, const LoopValues& values,
+                    const std::vector<IterationValue>& iterations, std::vector<ProgramNodePtr>& out);
+
+    void emitGates(std::size_t count);
+
+    const Binding* lookup(SymbolId symbol) const;
+    std::string substituteText(std::string_view text) const;
+    IndexExpr substituteIndex(const IndexExpr& index) const;
+    LoopValues substituteValues(const LoopValues& values) const;
+};
+
+/* EOF unroll.hpp */
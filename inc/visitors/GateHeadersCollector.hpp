@@ -18,6 +18,14 @@ public:
 
     std::any visitGateStatement(qasm3Parser::GateStatementContext *ctx) override;
     std::any visitDefStatement(qasm3Parser::DefStatementContext* ctx) override;
+    std::any visitIncludeStatement(qasm3Parser::IncludeStatementContext* ctx) override;
+
+    // Registration of a single header, shared with ProgramCollector when it
+    // collects headers itself (single-pass mode).
+    static std::size_t collectGateHeader(qasm3Parser::GateStatementContext* ctx,
+                                         IR& ir, ScopeManager& scopes);
+    static std::size_t collectDefHeader(qasm3Parser::DefStatementContext* ctx,
+                                        IR& ir, ScopeManager& scopes);
 
 private:
     IR& _ir;
@@ -11,15 +11,43 @@
 #include "qasm3ParserBaseVisitor.h"
 #include "ir.hpp"
 #include "ScopeManager.hpp"
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
 class ProgramCollector : public qasm3ParserBaseVisitor {
 public:
+    // gate id of calls to gates that are not defined yet (single-pass mode)
+    static constexpr idGate UNRESOLVED_GATE = static_cast<idGate>(-1);
+
+    // Single-pass mode: gate and def headers are registered when their
+    // definitions are reached, so no GateHeadersCollector pass is needed.
+    // Calls to gates defined further down are left UNRESOLVED_GATE and
+    // fixed up by resolveForwardReferences() after the walk.
+    bool collect_headers = false;
+
     ProgramCollector(IR& ir, ScopeManager& scopes);
 
+    /**
+     * Lowers top-level program statements into target instead of the global
+     * block and records the gates they use in used_gates instead of marking
+     * them in the IR. The IR is then only read, so several collectors (each
+     * with its own scopes) can lower parts of one program concurrently.
+     * Declarations must already have been collected into the IR. Nodes are
+     * allocated in arena, which the caller hands over to the IR afterwards.
+     */
+    ProgramCollector(IR& ir, ScopeManager& scopes, Block& target,
+                     std::unordered_set<std::size_t>& used_gates, Arena& arena);
+
     std::any visitGateCallStatement(qasm3Parser::GateCallStatementContext *ctx) override;
     std::any visitGateStatement(qasm3Parser::GateStatementContext *ctx) override;
     std::any visitForStatement(qasm3Parser::ForStatementContext *ctx) override;
 
     std::any visitDefStatement(qasm3Parser::DefStatementContext* ctx) override;
+    std::any visitIncludeStatement(qasm3Parser::IncludeStatementContext* ctx) override;
 
     std::any inProgram_visitGateCallStatement(qasm3Parser::GateCallStatementContext* ctx);
     std::any gateBody_visitGateCallStatement(qasm3Parser::GateCallStatementContext* ctx);
@@ -28,12 +56,28 @@ public:
     std::any visitConstDeclarationStatement(qasm3Parser::ConstDeclarationStatementContext *ctx) override;
     std::any visitQuantumDeclarationStatement(qasm3Parser::QuantumDeclarationStatementContext *ctx) override;
     std::any visitOldStyleDeclarationStatement(qasm3Parser::OldStyleDeclarationStatementContext *ctx) override;
+
+    /**
+     * @brief Resolves the calls recorded as forward references by name.
+     * @throws std::runtime_error for gates that were never defined.
+     */
+    void resolveForwardReferences();
 private:
     IR& _ir;
     ScopeManager& _scopes;
+    Arena& _arena;
     GateDef* current_gate = nullptr;
     std::vector<Block*> block_stack;
     std::vector<std::vector<GateStmt>*> body_stack;
+    std::unordered_set<std::size_t>* used_gates = nullptr;
+
+    // fix-up list of single-pass mode
+    std::vector<std::pair<GateApplication*, std::string>> pending_applications;
+    std::vector<idGate> pending_gate_bodies;
+
+    void markUsed(idGate id);
+    std::optional<std::ptrdiff_t> constantValue(std::string_view name) const;
+    void resolvePlacements(std::vector<GateStmt>& body);
 };
 
 /** EOF ProgramCollector.hpp */
\ No newline at end of file
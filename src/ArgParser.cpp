@@ -6,6 +6,7 @@
 #include "../inc/ArgParser.hpp"
 #include <iostream>
 #include <algorithm>
+#include <thread>
 
 void ArgParser::printUsage(const char* program_name) {
     std::cerr << "Usage: " << program_name << " [OPTIONS]\n\n";
@@ -15,14 +16,51 @@ void ArgParser::printUsage(const char* program_name) {
     std::cerr << "  -f, --file <input.qasm>      Input OpenQASM file (default: stdin)\n";
     std::cerr << "  -o, --output <output>        Output file (default: stdout)\n";
     std::cerr << "  -a, --algebraic <precision>  Enable algebraic matrices (default: off, 32)\n";
+    std::cerr << "  -b, --batch <list>           Convert every file listed in <list> (- for stdin) in one process,\n";
+    std::cerr << "                               one \"<input> [<output>]\" per line, reusing the warmed-up parser\n";
+    std::cerr << "                               (default output: the input with the target's extension,\n";
+    std::cerr << "                               <name>.out.<ext> if that is the input itself)\n";
+    std::cerr << "  -j, --jobs <n>               Parse with n threads, 0 = all cores (default: 1)\n";
     std::cerr << "  -h, --help                   Show this help message\n";
     std::cerr << "  --decompose-mcx              Decompose mcx gates into x, cx, and ccx gates (ancilla qubits added as needed, default: off)\n";
     std::cerr << "  --merge-registers            Merge all constant-size Nonparametric qubit registers into one (default: off)\n";
     std::cerr << "  --evaluluate-angles          Evaluate angles in parameters of gates such as rx, ry, rz to double\n";
+    std::cerr << "  --passes <p1,p2,...>         Run the given passes in order, e.g. decompose-mcx,merge-registers\n";
+    std::cerr << "                               (replaces the three options above; default: none)\n";
+    std::cerr << "                               Available: unroll, inline, decompose-mcx, cancel, merge-rotations,\n";
+    std::cerr << "                               merge-registers, evaluate-angles\n";
+    std::cerr << "  --unroll-budget <n>          Gates the unroll pass may emit, longer loops are kept (default: 1000000)\n";
+    std::cerr << "  --unroll-factor <k>          Keep interval loops with k copies of the body instead of\n";
+    std::cerr << "                               unrolling them fully (default: 0 = fully)\n";
+    std::cerr << "  --fast-path                  Parse flat gate-call circuits with the hand-written scanner,\n";
+    std::cerr << "                               falling back to ANTLR on other constructs (default: off)\n";
+    std::cerr << "  --two-pass                   Collect gate headers in a separate walk over the parse tree\n";
+    std::cerr << "                               instead of resolving forward references (default: off)\n";
+    std::cerr << "  --stream                     Parse, convert and print one statement at a time in bounded memory\n";
+    std::cerr << "                               (targets stim, openqasm3, openqasm2, stats; no passes; default: off)\n";
+    std::cerr << "  --no-library-cache           Do not read or write precompiled gate libraries (.qlib) for\n";
+    std::cerr << "                               json_gates/gates.json and included files (default: off)\n";
+    std::cerr << "  --emit-ir <file>             Save the IR after parsing as a binary snapshot for --load-ir\n";
+    std::cerr << "  --load-ir <file>             Load the IR from a snapshot written by --emit-ir instead of\n";
+    std::cerr << "                               parsing an input (passes and targets as usual)\n";
+    std::cerr << "  --cache-dir <dir>            Reuse outputs of earlier runs on the same input, includes, options\n";
+    std::cerr << "                               and gate table from a cache in <dir> (default: off)\n";
+    std::cerr << "  --cache-size <MiB>           Size limit of the cache, least recently used outputs are\n";
+    std::cerr << "                               removed first (default: 1024)\n";
+    std::cerr << "  --report-cache               Print cache hits and misses to stderr (default: off)\n";
+    std::cerr << "  --report-fast-path           Print why the fast path gave up on a file to stderr (default: off)\n";
+    std::cerr << "  --report-timing              Print per-phase and per-pass wall times to stderr (default: off)\n";
+    std::cerr << "  --report-memory              Print peak and current RSS per phase to stderr (default: off)\n";
     std::cerr << "Examples:\n";
     std::cerr << "  " << program_name << " -t stim -f circuit.qasm -o circuit.stim\n";
     std::cerr << "  " << program_name << " -f circuit.qasm < input.qasm\n";
     std::cerr << "  " << program_name << " < input.qasm > output.stim\n";
+    std::cerr << "  " << program_name << " -t openqasm3 -b circuits.txt\n";
+    std::cerr << "  " << program_name << " -f circuit.qasm --emit-ir circuit.qir -o circuit.stim\n";
+    std::cerr << "  " << program_name << " -t openqasm3 --load-ir circuit.qir -o circuit.qasm\n";
+    std::cerr << "  " << program_name << " -b circuits.txt --cache-dir ~/.cache/qfront\n";
+    std::cerr << "  " << program_name << " -f circuit.qasm --passes=decompose-mcx,merge-registers\n";
+    std::cerr << "  " << program_name << " -t openqasm2 -f circuit.qasm --passes=unroll --unroll-budget 100000\n";
 }
 
 ArgParser::Args ArgParser::parse(int argc, const char* argv[]) {
@@ -53,6 +91,25 @@ ArgParser::Args ArgParser::parse(int argc, const char* argv[]) {
             }
             args.output_file = argv[++i];
         }
+        else if (arg == "-b" || arg == "--batch") {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("Error: -b/--batch requires an argument");
+            }
+            args.batch_file = argv[++i];
+        }
+        else if (arg == "-j" || arg == "--jobs") {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("Error: -j/--jobs requires an argument");
+            }
+            try {
+                args.jobs = std::stoul(argv[++i]);
+            } catch (const std::exception&) {
+                throw std::invalid_argument("Error: -j/--jobs expects a number");
+            }
+            if (args.jobs == 0) {
+                args.jobs = std::max(1u, std::thread::hardware_concurrency());
+            }
+        }
         else if (arg == "-a" || arg == "--algebraic") {
             args.use_algebraic = true;
     
@@ -72,6 +129,71 @@ ArgParser::Args ArgParser::parse(int argc, const char* argv[]) {
             args.merge_registers = true;
         } else if (arg == "--evaluate-angles") {
             args.eval_angles = true;
+        } else if (arg == "--passes") {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("Error: --passes requires an argument");
+            }
+            args.passes = argv[++i];
+        } else if (arg.starts_with("--passes=")) {
+            args.passes = arg.substr(std::string_view("--passes=").size());
+        } else if (arg == "--unroll-budget") {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("Error: --unroll-budget requires an argument");
+            }
+            try {
+                args.unroll_budget = std::stoull(argv[++i]);
+            } catch (const std::exception&) {
+                throw std::invalid_argument("Error: --unroll-budget expects a number of gates");
+            }
+        } else if (arg == "--unroll-factor") {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("Error: --unroll-factor requires an argument");
+            }
+            try {
+                args.unroll_factor = std::stoul(argv[++i]);
+            } catch (const std::exception&) {
+                throw std::invalid_argument("Error: --unroll-factor expects a number");
+            }
+        } else if (arg == "--report-timing") {
+            args.report_timing = true;
+        } else if (arg == "--report-memory") {
+            args.report_memory = true;
+        } else if (arg == "--fast-path") {
+            args.fast_path = true;
+        } else if (arg == "--report-fast-path") {
+            args.report_fast_path = true;
+        } else if (arg == "--stream") {
+            args.stream = true;
+        } else if (arg == "--two-pass") {
+            args.two_pass = true;
+        } else if (arg == "--no-library-cache") {
+            args.no_library_cache = true;
+        } else if (arg == "--emit-ir") {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("Error: --emit-ir requires an argument");
+            }
+            args.emit_ir = argv[++i];
+        } else if (arg == "--load-ir") {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("Error: --load-ir requires an argument");
+            }
+            args.load_ir = argv[++i];
+        } else if (arg == "--cache-dir") {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("Error: --cache-dir requires an argument");
+            }
+            args.cache_dir = argv[++i];
+        } else if (arg == "--cache-size") {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("Error: --cache-size requires an argument");
+            }
+            try {
+                args.cache_size_mb = std::stoull(argv[++i]);
+            } catch (const std::exception&) {
+                throw std::invalid_argument("Error: --cache-size expects a number of MiB");
+            }
+        } else if (arg == "--report-cache") {
+            args.report_cache = true;
         }
         else {
             throw std::invalid_argument("Unknown option: " + arg);
@@ -88,6 +210,52 @@ ArgParser::Args ArgParser::parse(int argc, const char* argv[]) {
                                  " (valid: stim, autoq-para, openqasm3, openqasm2, stats, mosf)");
     }
 
+    if (!args.batch_file.empty() && (!args.input_file.empty() || !args.output_file.empty())) {
+        throw std::invalid_argument("Error: -b/--batch takes input and output files from the list, "
+                                    "not from -f/-o");
+    }
+
+    if (!args.load_ir.empty() && !args.input_file.empty()) {
+        throw std::invalid_argument("Error: --load-ir replaces the input, it cannot be combined with -f");
+    }
+    if ((!args.emit_ir.empty() || !args.load_ir.empty()) && (!args.batch_file.empty() || args.stream)) {
+        throw std::invalid_argument("Error: --emit-ir and --load-ir cannot be combined with -b/--batch or --stream");
+    }
+
+    if (!args.passes.empty() && (args.decompose_mcx || args.merge_registers || args.eval_angles)) {
+        throw std::invalid_argument("Error: --passes cannot be combined with --decompose-mcx, "
+                                    "--merge-registers or --evaluate-angles");
+    }
+
+    if (args.stream) {
+        if (args.target != "stim" &&
+            args.target != "openqasm3" &&
+            args.target != "openqasm2" &&
+            args.target != "stats") {
+            throw std::invalid_argument("Target " + args.target + " does not support --stream"
+                                        " (valid: stim, openqasm3, openqasm2, stats)");
+        }
+        if (args.decompose_mcx || args.merge_registers || args.eval_angles || !args.passes.empty()
+            || args.fast_path || args.jobs > 1) {
+            throw std::invalid_argument("--stream cannot be combined with --decompose-mcx, "
+                                        "--merge-registers, --evaluate-angles, --passes, --fast-path or --jobs");
+        }
+    }
+
+    // the pass options are shorthands for a pipeline
+    if (args.passes.empty()) {
+        const std::pair<bool, const char*> shorthands[] = {
+            {args.decompose_mcx, "decompose-mcx"},
+            {args.merge_registers, "merge-registers"},
+            {args.eval_angles, "evaluate-angles"},
+        };
+        for (const auto& [enabled, pass] : shorthands) {
+            if (enabled) {
+                args.passes += (args.passes.empty() ? "" : ",") + std::string(pass);
+            }
+        }
+    }
+
     return args;
 }
 
@@ -18,15 +18,7 @@ std::vector<GateDef> loadGates(const std::string& filename,
         const auto& names = g["names"];
 
         // plain string matrix
-        std::string stringMatrix = g["matrix"].dump();
-
-        // algebraic matrix if needed
-        ComplexMatrix<ACN> matrix = 
-        algebraic
-            ? createAlgebraicMatrix(stringMatrix, precision)
-            : createAlgebraicMatrixStub(2);  // TODO: some placeholder
-
-        AtomicGateSemantics sem(std::move(matrix), std::move(stringMatrix));
+        AtomicGateSemantics sem = makeAtomicSemantics(g["matrix"].dump(), algebraic, precision);
 
         GateDef def{
             .name = names.at(0).get<std::string>(),
@@ -56,6 +48,18 @@ std::vector<GateDef> loadGates(const std::string& filename,
     return gates;
 }
 
+AtomicGateSemantics makeAtomicSemantics(std::string string_matrix,
+                                        bool algebraic,
+                                        unsigned precision) {
+    // algebraic matrix if needed
+    ComplexMatrix<ACN> matrix = 
+    algebraic
+        ? createAlgebraicMatrix(string_matrix, precision)
+        : createAlgebraicMatrixStub(2);  // TODO: some placeholder
+
+    return AtomicGateSemantics(std::move(matrix), std::move(string_matrix));
+}
+
 ComplexMatrix<ACN> createAlgebraicMatrixStub(unsigned precision) {
     ACN zero(precision);
     MatrixBaker<ACN> baker{ &zero };
@@ -0,0 +1,407 @@
+/**
+ * @file CircuitDag.cpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ */
+
+#include "../inc/CircuitDag.hpp"
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+
+CircuitDag::CircuitDag(const IR& ir, Block& block) : _block(block) {
+    // indexed by slot, removed registers have no wires
+    const auto& registers = ir.getAllRegisters();
+    _wire_base.resize(registers.slotCount());
+    _wire_count.resize(registers.slotCount());
+    _sized.resize(registers.slotCount());
+
+    WireId wire_count = 0;
+    for (auto it = registers.begin(); it != registers.end(); ++it) {
+        const auto r = slotIndex(it.id());
+        const auto& reg = *it;
+        std::uint32_t size = 1;   // a register of symbolic size is a single wire
+        if (reg.kind == RegisterKind::Nonparametric) {
+            const auto* end = reg.size.data() + reg.size.size();
+            auto [ptr, ec] = std::from_chars(reg.size.data(), end, size);
+            _sized[r] = ec == std::errc() && ptr == end;
+            if (!_sized[r]) {
+                size = 1;
+            }
+        }
+        _wire_base[r] = wire_count;
+        _wire_count[r] = size;
+        wire_count += size;
+    }
+    _first.assign(wire_count, NONE);
+    _last.assign(wire_count, NONE);
+
+    std::vector<WireId> wires;
+    std::vector<idRegister> regs;
+
+    // exact wires of a gate, or whole registers if any operand is not exact
+    auto gateWires = [&](std::size_t count, auto reg_of, auto index_of) {
+        wires.clear();
+        bool exact = true;
+        for (std::size_t k = 0; k < count && exact; ++k) {
+            const auto index = index_of(k);
+            const WireId w = index ? wireOf(reg_of(k), *index) : NONE;
+            exact = w != NONE && std::find(wires.begin(), wires.end(), w) == wires.end();
+            wires.push_back(w);
+        }
+        if (exact) {
+            return false;
+        }
+
+        regs.clear();
+        for (std::size_t k = 0; k < count; ++k) {
+            regs.push_back(reg_of(k));
+        }
+        std::sort(regs.begin(), regs.end());
+        regs.erase(std::unique(regs.begin(), regs.end()), regs.end());
+        wires.clear();
+        for (auto r : regs) {
+            addRegisterWires(r, wires);
+        }
+        return true;
+    };
+
+    for (std::uint32_t i = 0; i < block.body.size(); ++i) {
+        const auto& node = *block.body[i];
+        switch (node.kind) {
+            case NodeKind::Gate: {
+                const auto& app = static_cast<const GateApplication&>(node);
+                const bool opaque = gateWires(app.operands.size(),
+                    [&](std::size_t k) { return app.operands[k].reg_id; },
+                    [&](std::size_t k) -> std::optional<std::ptrdiff_t> {
+                        const auto& index = app.operands[k].index;
+                        if (!index.isLiteral()) {
+                            return std::nullopt;
+                        }
+                        return index.offset;
+                    });
+                addNode(i, NONE, wires, opaque);
+                break;
+            }
+            case NodeKind::Stream: {
+                const auto& stream = static_cast<const GateStream&>(node);
+                for (std::uint32_t g = 0; g < stream.size(); ++g) {
+                    const auto first = stream.operand_offsets[g];
+                    const bool opaque = gateWires(stream.operand_offsets[g + 1] - first,
+                        [&](std::size_t k) -> idRegister { return stream.operand_regs[first + k]; },
+                        [&](std::size_t k) -> std::optional<std::ptrdiff_t> {
+                            return stream.operand_indices[first + k];
+                        });
+                    addNode(i, g, wires, opaque);
+                }
+                break;
+            }
+            case NodeKind::Loop:
+            case NodeKind::Conditional: {
+                // super-node over the registers of the whole body
+                regs.clear();
+                if (node.kind == NodeKind::Loop) {
+                    collectRegisters(static_cast<const LoopApplication&>(node).body.body, regs);
+                } else {
+                    const auto& cond = static_cast<const ConditionalApplication&>(node);
+                    collectRegisters(cond.then_body, regs);
+                    collectRegisters(cond.else_body, regs);
+                }
+                std::sort(regs.begin(), regs.end());
+                regs.erase(std::unique(regs.begin(), regs.end()), regs.end());
+                wires.clear();
+                for (auto r : regs) {
+                    addRegisterWires(r, wires);
+                }
+                addNode(i, NONE, wires, true);
+                break;
+            }
+        }
+    }
+
+    // sentinel closing the slot range of the last node
+    _nodes.push_back(Node{NONE, NONE, static_cast<std::uint32_t>(_slots.size())});
+}
+
+CircuitDag::WireId CircuitDag::wireOf(idRegister reg_id, std::ptrdiff_t index) const {
+    const auto r = slotIndex(reg_id);
+    if (r >= _sized.size() || !_sized[r]) {
+        return NONE;
+    }
+    const auto count = static_cast<std::ptrdiff_t>(_wire_count[r]);
+    if (index < 0) {
+        index += count;   // negative indices count from the end
+    }
+    if (index < 0 || index >= count) {
+        return NONE;
+    }
+    return _wire_base[r] + static_cast<WireId>(index);
+}
+
+void CircuitDag::addRegisterWires(idRegister reg_id, std::vector<WireId>& wires) const {
+    const auto r = slotIndex(reg_id);
+    if (r >= _wire_base.size()) {
+        return;
+    }
+    for (std::uint32_t k = 0; k < _wire_count[r]; ++k) {
+        wires.push_back(_wire_base[r] + k);
+    }
+}
+
+void CircuitDag::collectRegisters(const std::vector<ProgramNodePtr>& body,
+                                  std::vector<idRegister>& regs) const {
+    for (const auto& node_ptr : body) {
+        switch (node_ptr->kind) {
+            case NodeKind::Gate:
+                for (const auto& op : static_cast<const GateApplication&>(*node_ptr).operands) {
+                    regs.push_back(op.reg_id);
+                }
+                break;
+            case NodeKind::Stream: {
+                const auto& stream = static_cast<const GateStream&>(*node_ptr);
+                regs.insert(regs.end(), stream.operand_regs.begin(), stream.operand_regs.end());
+                break;
+            }
+            case NodeKind::Loop:
+                collectRegisters(static_cast<const LoopApplication&>(*node_ptr).body.body, regs);
+                break;
+            case NodeKind::Conditional: {
+                const auto& cond = static_cast<const ConditionalApplication&>(*node_ptr);
+                collectRegisters(cond.then_body, regs);
+                collectRegisters(cond.else_body, regs);
+                break;
+            }
+        }
+    }
+}
+
+void CircuitDag::addNode(std::uint32_t body_index, std::uint32_t stream_gate,
+                         const std::vector<WireId>& wires, bool opaque) {
+    const auto id = static_cast<NodeId>(_nodes.size());
+    _nodes.push_back(Node{body_index, stream_gate, static_cast<std::uint32_t>(_slots.size()), opaque});
+
+    for (auto w : wires) {
+        Slot s{w};
+        s.prev = _last[w];
+        if (s.prev != NONE) {
+            slotOn(s.prev, w).next = id;
+        } else {
+            _first[w] = id;
+        }
+        _last[w] = id;
+        _slots.push_back(s);
+    }
+}
+
+CircuitDag::Slot& CircuitDag::slotOn(NodeId node, WireId wire) {
+    auto begin = _slots.begin() + _nodes[node].slots;
+    auto end = _slots.begin() + _nodes[node + 1].slots;
+
+    // opaque nodes can span whole registers, their wires are sorted
+    auto it = _nodes[node].opaque
+        ? std::lower_bound(begin, end, wire, [](const Slot& s, WireId w) { return s.wire < w; })
+        : std::find_if(begin, end, [wire](const Slot& s) { return s.wire == wire; });
+    if (it == end || it->wire != wire) {
+        throw std::logic_error("CircuitDag: node is not on the wire");
+    }
+    return *it;
+}
+
+static const GateApplication* applicationOf(const ProgramNodeBase& node) {
+    return node_cast<GateApplication>(&node);
+}
+
+idGate CircuitDag::gateId(NodeId node) const {
+    const auto& n = _nodes[node];
+    const auto& body_node = *_block.body[n.body_index];
+    if (n.stream_gate != NONE) {
+        return static_cast<const GateStream&>(body_node).gates[n.stream_gate];
+    }
+    if (const auto* app = applicationOf(body_node)) {
+        return app->gate_id;
+    }
+    throw std::logic_error("CircuitDag: node is not a gate");
+}
+
+std::size_t CircuitDag::paramCount(NodeId node) const {
+    const auto& n = _nodes[node];
+    const auto& body_node = *_block.body[n.body_index];
+    if (n.stream_gate != NONE) {
+        const auto& stream = static_cast<const GateStream&>(body_node);
+        return stream.param_offsets[n.stream_gate + 1] - stream.param_offsets[n.stream_gate];
+    }
+    if (const auto* app = applicationOf(body_node)) {
+        return app->params.size();
+    }
+    throw std::logic_error("CircuitDag: node is not a gate");
+}
+
+std::string_view CircuitDag::param(NodeId node, std::size_t k) const {
+    const auto& n = _nodes[node];
+    const auto& body_node = *_block.body[n.body_index];
+    if (n.stream_gate != NONE) {
+        const auto& stream = static_cast<const GateStream&>(body_node);
+        return stream.params[stream.param_offsets[n.stream_gate] + k];
+    }
+    if (const auto* app = applicationOf(body_node)) {
+        return app->params[k];
+    }
+    throw std::logic_error("CircuitDag: node is not a gate");
+}
+
+void CircuitDag::setParam(NodeId node, std::size_t k, std::string_view value) {
+    const auto& n = _nodes[node];
+    auto& body_node = *_block.body[n.body_index];
+    if (n.stream_gate != NONE) {
+        auto& stream = static_cast<GateStream&>(body_node);
+        stream.params[stream.param_offsets[n.stream_gate] + k] = value;
+    } else if (auto* app = node_cast<GateApplication>(&body_node)) {
+        app->params[k] = value;
+    } else {
+        throw std::logic_error("CircuitDag: node is not a gate");
+    }
+}
+
+const GateApplication* CircuitDag::application(NodeId node) const {
+    const auto& n = _nodes[node];
+    if (n.stream_gate != NONE) {
+        return nullptr;
+    }
+    return applicationOf(*_block.body[n.body_index]);
+}
+
+std::vector<CircuitDag::NodeId> CircuitDag::topologicalOrder() const {
+    std::vector<NodeId> order;
+    for (NodeId id = 0; id < size(); ++id) {
+        if (!_nodes[id].removed) {
+            order.push_back(id);
+        }
+    }
+    return order;
+}
+
+std::vector<CircuitDag::NodeId> CircuitDag::frontLayer() const {
+    std::vector<NodeId> front;
+    for (NodeId id = 0; id < size(); ++id) {
+        if (_nodes[id].removed) {
+            continue;
+        }
+        bool first = true;
+        for (std::size_t k = 0; k < arity(id) && first; ++k) {
+            first = predecessor(id, k) == NONE;
+        }
+        if (first) {
+            front.push_back(id);
+        }
+    }
+    return front;
+}
+
+std::vector<std::vector<CircuitDag::NodeId>> CircuitDag::layers() const {
+    // program order is topological, so every predecessor has its depth already
+    std::vector<std::uint32_t> depth(size(), 0);
+    std::vector<std::vector<NodeId>> result;
+    for (NodeId id = 0; id < size(); ++id) {
+        if (_nodes[id].removed) {
+            continue;
+        }
+        std::uint32_t d = 0;
+        for (std::size_t k = 0; k < arity(id); ++k) {
+            if (auto prev = predecessor(id, k); prev != NONE) {
+                d = std::max(d, depth[prev] + 1);
+            }
+        }
+        depth[id] = d;
+        if (d >= result.size()) {
+            result.resize(d + 1);
+        }
+        result[d].push_back(id);
+    }
+    return result;
+}
+
+std::vector<CircuitDag::NodeId> CircuitDag::pastLightCone(NodeId node) const {
+    std::vector<bool> seen(size(), false);
+    std::vector<NodeId> pending{node};
+    seen[node] = true;
+
+    std::vector<NodeId> cone;
+    while (!pending.empty()) {
+        const auto id = pending.back();
+        pending.pop_back();
+        for (std::size_t k = 0; k < arity(id); ++k) {
+            const auto prev = predecessor(id, k);
+            if (prev != NONE && !seen[prev]) {
+                seen[prev] = true;
+                cone.push_back(prev);
+                pending.push_back(prev);
+            }
+        }
+    }
+    std::sort(cone.begin(), cone.end());
+    return cone;
+}
+
+void CircuitDag::remove(NodeId node) {
+    if (_nodes[node].removed) {
+        return;
+    }
+    for (std::size_t k = 0; k < arity(node); ++k) {
+        auto& s = slot(node, k);
+        if (s.prev != NONE) {
+            slotOn(s.prev, s.wire).next = s.next;
+        } else {
+            _first[s.wire] = s.next;
+        }
+        if (s.next != NONE) {
+            slotOn(s.next, s.wire).prev = s.prev;
+        } else {
+            _last[s.wire] = s.prev;
+        }
+        s.prev = s.next = NONE;
+    }
+    _nodes[node].removed = true;
+}
+
+void CircuitDag::commit(Arena& arena) {
+    std::vector<ProgramNodePtr> body;
+    body.reserve(_block.body.size());
+
+    NodeId id = 0;
+    while (id < size()) {
+        auto& node_ptr = _block.body[_nodes[id].body_index];
+        if (_nodes[id].stream_gate == NONE) {
+            if (!_nodes[id].removed) {
+                body.push_back(std::move(node_ptr));
+            }
+            ++id;
+            continue;
+        }
+
+        // the gates of a stream are consecutive nodes
+        const auto& stream = static_cast<const GateStream&>(*node_ptr);
+        const NodeId end = id + static_cast<NodeId>(stream.size());
+        const bool intact = std::none_of(_nodes.begin() + id, _nodes.begin() + end,
+                                         [](const Node& n) { return n.removed; });
+        if (intact) {
+            body.push_back(std::move(node_ptr));
+        } else {
+            auto packed = makeNode<GateStream>(arena);
+            for (NodeId g = id; g < end; ++g) {
+                if (!_nodes[g].removed) {
+                    packed->append(stream, _nodes[g].stream_gate);
+                }
+            }
+            if (packed->size() != 0) {
+                body.push_back(std::move(packed));
+            }
+        }
+        id = end;
+    }
+
+    _block.body = std::move(body);
+    _nodes.assign(1, Node{NONE, NONE, 0});
+    _slots.clear();
+}
+
+/* EOF CircuitDag.cpp */
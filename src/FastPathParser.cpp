@@ -0,0 +1,602 @@
+/**
+ * @file FastPathParser.cpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ */
+
+#include "../inc/FastPathParser.hpp"
+#include "../inc/GateLibrary.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+
+namespace {
+
+// thrown when the input leaves the supported subset
+struct Unsupported {
+    std::string reason;
+    std::size_t line;
+};
+
+// reserved words of qasm3Lexer.g4 (minus literals that may appear in expressions)
+const std::unordered_set<std::string_view> keywords = {
+    "OPENQASM", "include", "defcalgrammar", "def", "cal", "defcal", "gate",
+    "extern", "box", "let", "break", "continue", "if", "else", "end",
+    "return", "for", "while", "in", "switch", "case", "default", "nop",
+    "pragma", "input", "output", "const", "readonly", "mutable", "qreg",
+    "qubit", "creg", "bool", "bit", "int", "uint", "float", "angle",
+    "complex", "array", "void", "duration", "stretch", "gphase", "inv",
+    "pow", "ctrl", "negctrl", "durationof", "delay", "reset", "measure",
+    "barrier", "im"
+};
+
+const std::unordered_set<std::string_view> scalar_types = {
+    "bool", "bit", "int", "uint", "float", "angle"
+};
+
+bool isIdentifierStart(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+bool isIdentifierChar(char c) {
+    return isIdentifierStart(c) || isDigit(c);
+}
+
+} // namespace
+
+FastPathParser::FastPathParser(IR& ir, ScopeManager& scopes)
+    : _ir(ir), _scopes(scopes) {}
+
+bool FastPathParser::parse(std::string_view source) {
+    _source = source;
+    _pos = 0;
+    _line = 1;
+    _has_lookahead = false;
+    _at_program_start = true;
+
+    try {
+        while (peek().kind != TokenKind::End) {
+            parseStatement();
+            _at_program_start = false;
+        }
+        return true;
+    } catch (const Unsupported& u) {
+        _failure_reason = u.reason;
+        _failure_line = u.line;
+    } catch (const std::exception& e) {
+        // semantic error; the ANTLR path reports it with full context
+        _failure_reason = e.what();
+        _failure_line = _line;
+    }
+    return false;
+}
+
+void FastPathParser::unsupported(const std::string& what) const {
+    throw Unsupported{what, _has_lookahead ? _lookahead.line : _line};
+}
+
+FastPathParser::Token FastPathParser::lex() {
+    const std::size_t size = _source.size();
+
+    // whitespace and comments
+    while (_pos < size) {
+        const char c = _source[_pos];
+        if (c == ' ' || c == '\t' || c == '\r') {
+            ++_pos;
+        } else if (c == '\n') {
+            ++_line;
+            ++_pos;
+        } else if (c == '/' && _pos + 1 < size && _source[_pos + 1] == '/') {
+            while (_pos < size && _source[_pos] != '\n') ++_pos;
+        } else if (c == '/' && _pos + 1 < size && _source[_pos + 1] == '*') {
+            auto end = _source.find("*/", _pos + 2);
+            if (end == std::string_view::npos) {
+                unsupported("unterminated block comment");
+            }
+            for (std::size_t i = _pos; i < end; ++i) {
+                if (_source[i] == '\n') ++_line;
+            }
+            _pos = end + 2;
+        } else {
+            break;
+        }
+    }
+
+    if (_pos >= size) {
+        return Token{TokenKind::End, {}, _line};
+    }
+
+    const std::size_t start = _pos;
+    const char c = _source[_pos];
+
+    if (isIdentifierStart(c)) {
+        while (_pos < size && isIdentifierChar(_source[_pos])) ++_pos;
+        if (_pos < size && static_cast<unsigned char>(_source[_pos]) >= 0x80) {
+            unsupported("non-ASCII identifier");
+        }
+        return Token{TokenKind::Identifier, _source.substr(start, _pos - start), _line};
+    }
+
+    if (isDigit(c) || (c == '.' && _pos + 1 < size && isDigit(_source[_pos + 1]))) {
+        bool is_float = false;
+        while (_pos < size && isDigit(_source[_pos])) ++_pos;
+        if (_pos < size && _source[_pos] == '.') {
+            is_float = true;
+            ++_pos;
+            while (_pos < size && isDigit(_source[_pos])) ++_pos;
+        }
+        if (_pos < size && (_source[_pos] == 'e' || _source[_pos] == 'E')) {
+            std::size_t exp = _pos + 1;
+            if (exp < size && (_source[exp] == '+' || _source[exp] == '-')) ++exp;
+            if (exp < size && isDigit(_source[exp])) {
+                is_float = true;
+                _pos = exp;
+                while (_pos < size && isDigit(_source[_pos])) ++_pos;
+            }
+        }
+        // hex/binary/octal, digit separators, timing and imaginary suffixes
+        if (_pos < size && (isIdentifierChar(_source[_pos]) || _source[_pos] == '.')) {
+            unsupported("numeric literal form");
+        }
+        return Token{is_float ? TokenKind::Float : TokenKind::Integer,
+                     _source.substr(start, _pos - start), _line};
+    }
+
+    if (c == '"' || c == '\'') {
+        ++_pos;
+        while (_pos < size && _source[_pos] != c && _source[_pos] != '\n') ++_pos;
+        if (_pos >= size || _source[_pos] != c) {
+            unsupported("unterminated string literal");
+        }
+        ++_pos;
+        return Token{TokenKind::String, _source.substr(start, _pos - start), _line};
+    }
+
+    switch (c) {
+        case ';': case ',': case '(': case ')': case '[': case ']':
+        case '{': case '}': case '+': case '-': case '*': case '/':
+        case '%': case '^': case '=': case ':':
+            ++_pos;
+            return Token{TokenKind::Punct, _source.substr(start, 1), _line};
+        default:
+            break;
+    }
+
+    unsupported(std::string("unexpected character '") + c + "'");
+}
+
+const FastPathParser::Token& FastPathParser::peek() {
+    if (!_has_lookahead) {
+        _lookahead = lex();
+        _has_lookahead = true;
+    }
+    return _lookahead;
+}
+
+FastPathParser::Token FastPathParser::take() {
+    Token token = peek();
+    _has_lookahead = false;
+    return token;
+}
+
+bool FastPathParser::atPunct(char c) {
+    const Token& token = peek();
+    return token.kind == TokenKind::Punct && token.text[0] == c;
+}
+
+FastPathParser::Token FastPathParser::expectPunct(char c) {
+    if (!atPunct(c)) {
+        unsupported(std::string("expected '") + c + "'");
+    }
+    return take();
+}
+
+FastPathParser::Token FastPathParser::expectIdentifier() {
+    const Token& token = peek();
+    if (token.kind != TokenKind::Identifier || keywords.count(token.text)) {
+        unsupported("expected identifier");
+    }
+    return take();
+}
+
+FastPathParser::Expression FastPathParser::takeExpression(bool stop_at_comma) {
+    Expression expr;
+    int depth = 0;
+    TokenKind previous = TokenKind::End;
+
+    for (;;) {
+        const Token& token = peek();
+
+        if (token.kind == TokenKind::End || token.kind == TokenKind::String) {
+            unsupported("unexpected token in expression");
+        }
+
+        if (token.kind == TokenKind::Punct) {
+            const char c = token.text[0];
+            if (depth == 0 && (c == ';' || c == ')' || c == ']')) break;
+            if (depth == 0 && c == ',') {
+                if (stop_at_comma) break;
+                unsupported("multiple indices");
+            }
+            if (c == '{' || c == '}' || c == '=' || c == ':' || c == ';') {
+                unsupported("unsupported expression form");
+            }
+            if (c == '(' || c == '[') ++depth;
+            if (c == ')' || c == ']') --depth;
+        } else if (token.kind == TokenKind::Identifier) {
+            if (keywords.count(token.text)) {
+                unsupported("keyword '" + std::string(token.text) + "' in expression");
+            }
+            if (previous == TokenKind::Integer || previous == TokenKind::Float) {
+                unsupported("literal with unit or imaginary suffix");
+            }
+        }
+
+        if (expr.tokens == 0) {
+            expr.first_kind = token.kind;
+        }
+        previous = token.kind;
+        expr.text += token.text;
+        ++expr.tokens;
+        take();
+    }
+
+    if (expr.tokens == 0) {
+        unsupported("empty expression");
+    }
+    return expr;
+}
+
+void FastPathParser::parseStatement() {
+    const Token& token = peek();
+
+    if (token.kind != TokenKind::Identifier) {
+        unsupported("statement starting with '" + std::string(token.text) + "'");
+    }
+
+    const std::string_view word = token.text;
+    if (word == "OPENQASM") {
+        parseVersion();
+    } else if (word == "include") {
+        parseInclude();
+    } else if (word == "qubit") {
+        parseQubitDeclaration();
+    } else if (word == "qreg") {
+        parseOldStyleDeclaration(RegisterType::Qubit);
+    } else if (word == "creg") {
+        parseOldStyleDeclaration(RegisterType::Int);
+    } else if (word == "const") {
+        parseConstDeclaration();
+    } else if (word == "gate") {
+        parseGateDefinition();
+    } else if (keywords.count(word)) {
+        unsupported("'" + std::string(word) + "' statement");
+    } else {
+        Token name = take();
+        parseGateCall(name);
+    }
+}
+
+void FastPathParser::parseVersion() {
+    if (!_at_program_start) {
+        unsupported("version statement after the first statement");
+    }
+    take();
+    const Token& version = peek();
+    if (version.kind != TokenKind::Integer && version.kind != TokenKind::Float) {
+        unsupported("version specifier");
+    }
+    take();
+    expectPunct(';');
+}
+
+void FastPathParser::parseInclude() {
+    take();
+    if (peek().kind != TokenKind::String) {
+        unsupported("include without a path");
+    }
+    Token path = take();
+    expectPunct(';');
+    gate_library::include(gate_library::includeName(path.text), _ir, _scopes);
+}
+
+void FastPathParser::parseRegisterSize(RegisterDef& reg) {
+    if (!atPunct('[')) {
+        // single qubit
+        reg.kind = RegisterKind::Nonparametric;
+        reg.size = "1";
+        return;
+    }
+
+    take();
+    Token size = take();
+    expectPunct(']');
+
+    if (size.kind == TokenKind::Integer) {
+        reg.kind = RegisterKind::Nonparametric;
+        reg.size = std::string(size.text);
+        return;
+    }
+
+    if (size.kind != TokenKind::Identifier) {
+        unsupported("register size expression");
+    }
+
+    // find symbol to check if it's a const variable
+    const std::string size_text(size.text);
+    auto* sym = _scopes.lookupSymbol(size_text);
+    if (!sym || sym->kind != SymbolKind::ConstVar) {
+        throw std::runtime_error(
+            "Cannot determine constant value of register size from \""
+            + size_text + "\".");
+    }
+
+    const auto& variable = _ir.getGlobalVariable(size_text);
+    if (variable.compile_time_value.empty()) {
+        reg.kind = RegisterKind::Parametric;
+        reg.size = size_text;
+    } else {
+        reg.kind = RegisterKind::Nonparametric;
+        reg.size = variable.compile_time_value;
+    }
+}
+
+void FastPathParser::declareRegister(RegisterDef& reg) {
+    auto id = _ir.addRegister(reg);
+
+    _scopes.addSymbol(Symbol{
+        .name = reg.name,
+        .kind = SymbolKind::Register,
+        .ir_ref = id,
+    });
+}
+
+std::optional<std::ptrdiff_t> FastPathParser::constantValue(std::string_view name) const {
+    // a loop variable or parameter may shadow a global const
+    auto* sym = _scopes.lookupSymbol(name);
+    if (!sym || sym->kind != SymbolKind::ConstVar) {
+        return std::nullopt;
+    }
+    return _ir.getConstantValue(name);
+}
+
+void FastPathParser::parseQubitDeclaration() {
+    take();
+
+    RegisterDef reg;
+    reg.type = RegisterType::Qubit;
+    parseRegisterSize(reg);
+    reg.name = std::string(expectIdentifier().text);
+    expectPunct(';');
+
+    declareRegister(reg);
+}
+
+void FastPathParser::parseOldStyleDeclaration(RegisterType type) {
+    take();
+
+    RegisterDef reg;
+    reg.type = type;
+    reg.name = std::string(expectIdentifier().text);
+    parseRegisterSize(reg);
+    expectPunct(';');
+
+    declareRegister(reg);
+}
+
+void FastPathParser::parseConstDeclaration() {
+    take();
+
+    const Token& type_token = peek();
+    if (type_token.kind != TokenKind::Identifier || !scalar_types.count(type_token.text)) {
+        unsupported("const type");
+    }
+    std::string type(take().text);
+    if (atPunct('[')) {
+        take();
+        type += "[" + takeExpression(false).text + "]";
+        expectPunct(']');
+    }
+
+    std::string name(expectIdentifier().text);
+    expectPunct('=');
+    Expression initializer = takeExpression(false);
+    expectPunct(';');
+
+    // same rule as parse_utils::tryExtractIntConst: only a bare decimal literal
+    std::string compile_time_value;
+    if (initializer.tokens == 1 && initializer.first_kind == TokenKind::Integer) {
+        compile_time_value = std::to_string(std::stoi(initializer.text));
+    }
+
+    VariableDef var;
+    var.name = name;
+    var.type.base = type;
+    var.is_const = true;
+    var.compile_time_value = compile_time_value;
+    var.initializer = initializer.text;
+
+    _ir.getGlobalBlock().variables.push_back(var);
+    _scopes.addSymbol(Symbol{
+        .name = name,
+        .kind = SymbolKind::ConstVar,
+    });
+}
+
+std::vector<std::string> FastPathParser::parseParameterList() {
+    std::vector<std::string> params;
+    expectPunct('(');
+    while (!atPunct(')')) {
+        params.push_back(takeExpression(true).text);
+        if (!atPunct(',')) break;
+        take();
+    }
+    expectPunct(')');
+    return params;
+}
+
+void FastPathParser::parseGateDefinition() {
+    take();
+
+    GateDef gate;
+    gate.name = std::string(expectIdentifier().text);
+    gate.kind = GateKind::Composite;
+
+    if (atPunct('(')) {
+        take();
+        while (!atPunct(')')) {
+            std::string name(expectIdentifier().text);
+            gate.parameter_index[name] = gate.parameters.size();
+            gate.parameters.push_back(name);
+            if (!atPunct(',')) break;
+            take();
+        }
+        expectPunct(')');
+    }
+
+    do {
+        std::string name(expectIdentifier().text);
+        gate.argument_index[name] = gate.argument_qubits.size();
+        gate.argument_qubits.push_back(name);
+        if (!atPunct(',')) break;
+        take();
+    } while (!atPunct('{'));
+
+    gate.semantics = CompositeGateBody{};
+
+    auto id = _ir.addGate(gate);
+    _scopes.addSymbol(Symbol{
+        .name = gate.name,
+        .kind = SymbolKind::Gate,
+        .ir_ref = id,
+    });
+
+    // body, scoped as in ProgramCollector::visitGateStatement
+    GateDef& def = _ir.getGate(id);
+    _scopes.enterScope(ScopeKind::GateOrSubroutine);
+    for (const auto& a : def.argument_qubits) {
+        _scopes.addSymbol(Symbol{
+            .name = a,
+            .kind = SymbolKind::Qubit,
+        });
+    }
+    for (const auto& p : def.parameters) {
+        _scopes.addSymbol(Symbol{
+            .name = p,
+            .kind = SymbolKind::Parameter,
+        });
+    }
+
+    auto& body = std::get<CompositeGateBody>(def.semantics).body;
+
+    expectPunct('{');
+    while (!atPunct('}')) {
+        const Token& token = peek();
+        if (token.kind != TokenKind::Identifier || keywords.count(token.text)) {
+            unsupported("statement in gate body");
+        }
+        Token name = take();
+        parseGateBodyCall(name, def, body);
+    }
+    expectPunct('}');
+
+    _scopes.exitScope();
+}
+
+void FastPathParser::parseGateBodyCall(const Token& name, GateDef& gate, std::vector<GateStmt>& body) {
+    GatePlacement placement;
+    placement.gate_name = std::string(name.text);
+
+    auto sym = _scopes.lookupSymbol(placement.gate_name);
+    if (!sym || sym->kind != SymbolKind::Gate) {
+        throw std::runtime_error(
+            "Unknown gate '" + placement.gate_name + "' in gate body");
+    }
+    placement.gate_id = std::get<size_t>(sym->ir_ref);
+    _ir.markGateUsed(placement.gate_id);
+
+    if (atPunct('(')) {
+        placement.params = parseParameterList();
+    }
+
+    do {
+        std::string operand(expectIdentifier().text);
+        if (atPunct('[')) {
+            // indices on gate arguments are ignored, as in ProgramCollector
+            take();
+            takeExpression(false);
+            expectPunct(']');
+        }
+
+        auto operand_sym = _scopes.lookupSymbol(operand);
+        if (!operand_sym || operand_sym->kind != SymbolKind::Qubit) {
+            throw std::runtime_error("Unknown qubit argument: " + operand);
+        }
+        placement.relativeInputs.push_back(gate.argument_index.at(operand));
+
+        if (!atPunct(',')) break;
+        take();
+    } while (!atPunct(';'));
+    expectPunct(';');
+
+    body.push_back(std::move(placement));
+}
+
+void FastPathParser::parseGateCall(const Token& name) {
+    auto* sym = _scopes.lookupSymbol(name.text);
+    if (!sym || sym->kind != SymbolKind::Gate) {
+        // assignments, subroutine calls, ... are left to the full grammar
+        unsupported("statement starting with '" + std::string(name.text) + "'");
+    }
+
+    auto application = makeNode<GateApplication>(_ir.arena());
+    application->gate_id = std::get<size_t>(sym->ir_ref);
+    _ir.markGateUsed(application->gate_id);
+
+    if (atPunct('(')) {
+        auto params = parseParameterList();
+        application->params.assign(params.begin(), params.end());
+    }
+    if (atPunct('[')) {
+        unsupported("gate call with a duration designator");
+    }
+
+    do {
+        std::string operand(expectIdentifier().text);
+
+        auto* reg_sym = _scopes.lookupSymbol(operand);
+        if (!reg_sym || reg_sym->kind != SymbolKind::Register) {
+            throw std::runtime_error("Unknown register: " + operand);
+        }
+
+        RegisterRef ref;
+        ref.reg_id = std::get<size_t>(reg_sym->ir_ref);
+
+        if (atPunct('[')) {
+            take();
+            ref.index = parseIndexExpr(takeExpression(false).text,
+                [this](std::string_view name) { return constantValue(name); });
+            expectPunct(']');
+            if (atPunct('[')) {
+                unsupported("multiple index operators");
+            }
+        } else {
+            ref.index = IndexExpr::literal(0);
+        }
+
+        application->operands.push_back(std::move(ref));
+
+        if (!atPunct(',')) break;
+        take();
+    } while (!atPunct(';'));
+    expectPunct(';');
+
+    _ir.getGlobalBlock().body.push_back(std::move(application));
+}
+
+/* EOF FastPathParser.cpp */
@@ -0,0 +1,64 @@
+/**
+ * @file Frontend.cpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ */
+
+#include "../inc/Frontend.hpp"
+
+namespace frontend {
+
+const char* toString(PredictionStage stage) {
+    switch (stage) {
+        case PredictionStage::SLL: return "SLL";
+        case PredictionStage::LL:  return "LL";
+    }
+    return "unknown";
+}
+
+ParseResult parseTwoStage(qasm3Parser& parser, antlr4::CommonTokenStream& tokens,
+                          bool report_errors) {
+    ParseResult result;
+
+    // lex everything up front so the stages below measure parsing only
+    auto start = Clock::now();
+    tokens.fill();
+    result.lex_ms = elapsedMs(start);
+
+    auto* interpreter = parser.getInterpreter<antlr4::atn::ParserATNSimulator>();
+
+    // stage 1: SLL, bail out on the first syntax error without reporting it
+    interpreter->setPredictionMode(antlr4::atn::PredictionMode::SLL);
+    parser.removeErrorListeners();
+    parser.setErrorHandler(std::make_shared<antlr4::BailErrorStrategy>());
+
+    start = Clock::now();
+    try {
+        result.tree = parser.program();
+        result.sll_ms = elapsedMs(start);
+        result.stage = PredictionStage::SLL;
+        return result;
+    } catch (const antlr4::ParseCancellationException&) {
+        result.sll_ms = elapsedMs(start);
+    }
+
+    // stage 2: full LL with the usual error reporting and recovery
+    tokens.seek(0);
+    parser.reset();
+    if (report_errors) {
+        parser.addErrorListener(&antlr4::ConsoleErrorListener::INSTANCE);
+    }
+    parser.setErrorHandler(std::make_shared<antlr4::DefaultErrorStrategy>());
+    interpreter->setPredictionMode(antlr4::atn::PredictionMode::LL);
+
+    start = Clock::now();
+    result.tree = parser.program();
+    result.ll_ms = elapsedMs(start);
+    result.stage = PredictionStage::LL;
+
+    return result;
+}
+
+} // namespace frontend
+
+/* EOF Frontend.cpp */
@@ -0,0 +1,410 @@
+/**
+ * @file GateLibrary.cpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ *
+ * Library layout (little endian, see Serialize.hpp):
+ *
+ *   "QFLB" u32 version  u64 source size  i64 source mtime (ns)
+ *   u32 entry count, entries:
+ *     u8 0  gate:    name, aliases, argument qubits, parameters, u8 kind,
+ *                    atomic: string matrix / composite: body
+ *     u8 1  include: name
+ *   body: u32 count, statements:
+ *     u8 0  placement: gate name, u32 count + u64 relative inputs, params
+ *     u8 1  repeat:    u64 count, body
+ */
+
+#include "../inc/GateLibrary.hpp"
+#include "../inc/AtomicGateLoader.hpp"
+#include "../inc/Frontend.hpp"
+#include "../inc/MappedCharStream.hpp"
+#include "../inc/Serialize.hpp"
+#include "../inc/visitors/ProgramCollector.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+#include <sys/stat.h>
+
+namespace fs = std::filesystem;
+
+namespace gate_library {
+
+namespace {
+
+constexpr std::string_view MAGIC = "QFLB";
+constexpr std::uint32_t FORMAT_VERSION = 1;
+
+enum : std::uint8_t { GATE_ENTRY = 0, INCLUDE_ENTRY = 1 };
+enum : std::uint8_t { PLACEMENT_STMT = 0, REPEAT_STMT = 1 };
+
+struct SourceStamp {
+    std::uint64_t size = 0;
+    std::int64_t mtime_ns = 0;
+};
+
+// an included file name, or a gate defined by the library
+using Entry = std::variant<std::string, GateDef>;
+using EntryRef = std::variant<std::string, const GateDef*>;
+
+Options options;
+std::vector<std::string> include_stack;   // files being included, for cycles
+
+std::optional<SourceStamp> stampOf(const std::string& path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return std::nullopt;
+    }
+    return SourceStamp{
+        static_cast<std::uint64_t>(st.st_size),
+        static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1'000'000'000 + st.st_mtim.tv_nsec,
+    };
+}
+
+std::string libraryPath(const std::string& source) {
+    return source + ".qlib";
+}
+
+void writeBody(serialize::Writer& out, const std::vector<GateStmt>& body) {
+    out.u32(static_cast<std::uint32_t>(body.size()));
+    for (const auto& stmt : body) {
+        if (const auto* placement = std::get_if<GatePlacement>(&stmt)) {
+            out.u8(PLACEMENT_STMT);
+            out.string(placement->gate_name);
+            out.u32(static_cast<std::uint32_t>(placement->relativeInputs.size()));
+            for (auto input : placement->relativeInputs) {
+                out.u64(input);
+            }
+            out.strings(placement->params);
+        } else {
+            const auto& loop = std::get<RepeatBlock>(stmt);
+            out.u8(REPEAT_STMT);
+            out.u64(loop.count);
+            writeBody(out, loop.body);
+        }
+    }
+}
+
+std::vector<GateStmt> readBody(serialize::Reader& in) {
+    std::vector<GateStmt> body;
+    const std::uint32_t count = in.u32();
+    for (std::uint32_t i = 0; i < count; ++i) {
+        const std::uint8_t tag = in.u8();
+        if (tag == PLACEMENT_STMT) {
+            GatePlacement placement;
+            placement.gate_id = ProgramCollector::UNRESOLVED_GATE;
+            placement.gate_name = in.string();
+            const std::uint32_t inputs = in.u32();
+            for (std::uint32_t k = 0; k < inputs; ++k) {
+                placement.relativeInputs.push_back(in.u64());
+            }
+            placement.params = in.strings();
+            body.push_back(std::move(placement));
+        } else if (tag == REPEAT_STMT) {
+            RepeatBlock loop;
+            loop.count = in.u64();
+            loop.body = readBody(in);
+            body.push_back(std::move(loop));
+        } else {
+            throw std::runtime_error("Corrupt gate library");
+        }
+    }
+    return body;
+}
+
+} // namespace
+
+void writeGate(serialize::Writer& out, const GateDef& gate) {
+    out.string(gate.name.view());
+    out.strings(gate.aliases);
+    out.strings(gate.argument_qubits);
+    out.strings(gate.parameters);
+    out.u8(gate.kind == GateKind::Atomic ? 0 : 1);
+    if (const auto* atomic = std::get_if<AtomicGateSemantics>(&gate.semantics)) {
+        out.string(atomic->string_matrix);
+    } else {
+        writeBody(out, std::get<CompositeGateBody>(gate.semantics).body);
+    }
+}
+
+GateDef readGate(serialize::Reader& in) {
+    GateDef gate;
+    gate.name = in.string();
+    gate.aliases = in.strings();
+    gate.argument_qubits = in.strings();
+    gate.parameters = in.strings();
+    for (std::size_t i = 0; i < gate.argument_qubits.size(); ++i) {
+        gate.argument_index[gate.argument_qubits[i]] = i;
+    }
+    for (std::size_t i = 0; i < gate.parameters.size(); ++i) {
+        gate.parameter_index[gate.parameters[i]] = i;
+    }
+
+    const std::uint8_t kind = in.u8();
+    if (kind > 1) {
+        throw std::runtime_error("Corrupt gate " + gate.name);
+    }
+    if (kind == 0) {
+        gate.kind = GateKind::Atomic;
+        // only the string form is stored, algebraic matrices depend on the options
+        gate.semantics.emplace<AtomicGateSemantics>(
+            makeAtomicSemantics(in.string(), options.algebraic, options.precision));
+    } else {
+        gate.kind = GateKind::Composite;
+        gate.semantics = CompositeGateBody{readBody(in)};
+    }
+    return gate;
+}
+
+namespace {
+
+void saveLibrary(const std::string& path, const SourceStamp& stamp,
+                 const std::vector<EntryRef>& entries) {
+    serialize::Writer out;
+    out.raw(MAGIC);
+    out.u32(FORMAT_VERSION);
+    out.u64(stamp.size);
+    out.i64(stamp.mtime_ns);
+    out.u32(static_cast<std::uint32_t>(entries.size()));
+    for (const auto& entry : entries) {
+        if (const auto* name = std::get_if<std::string>(&entry)) {
+            out.u8(INCLUDE_ENTRY);
+            out.string(*name);
+        } else {
+            out.u8(GATE_ENTRY);
+            writeGate(out, *std::get<const GateDef*>(entry));
+        }
+    }
+
+    // a read-only directory just means no cache
+    serialize::writeFileAtomically(path, out.bytes());
+}
+
+std::optional<std::vector<Entry>> loadLibrary(const std::string& path, const SourceStamp& stamp) {
+    if (!fs::exists(path)) {
+        return std::nullopt;
+    }
+
+    try {
+        auto mapped = MappedCharStream::fromFile(path);
+        serialize::Reader in(mapped->contents());
+
+        if (in.raw(MAGIC.size()) != MAGIC || in.u32() != FORMAT_VERSION
+            || in.u64() != stamp.size || in.i64() != stamp.mtime_ns) {
+            return std::nullopt;   // stale or foreign, rebuilt by the caller
+        }
+
+        std::vector<Entry> entries;
+        const std::uint32_t count = in.u32();
+        for (std::uint32_t i = 0; i < count; ++i) {
+            const std::uint8_t tag = in.u8();
+            if (tag == INCLUDE_ENTRY) {
+                entries.emplace_back(in.string());
+            } else if (tag == GATE_ENTRY) {
+                entries.emplace_back(readGate(in));
+            } else {
+                return std::nullopt;
+            }
+        }
+        return entries;
+    } catch (const std::exception&) {
+        // truncated or corrupt, also a matrix the JSON parser rejects
+        return std::nullopt;
+    }
+}
+
+void resolvePlacements(std::vector<GateStmt>& body, IR& ir, const ScopeManager& scopes) {
+    for (auto& stmt : body) {
+        if (auto* loop = std::get_if<RepeatBlock>(&stmt)) {
+            resolvePlacements(loop->body, ir, scopes);
+            continue;
+        }
+
+        auto& placement = std::get<GatePlacement>(stmt);
+        auto* sym = scopes.lookupSymbol(placement.gate_name);
+        if (!sym || sym->kind != SymbolKind::Gate) {
+            throw std::runtime_error(
+                "Unknown gate '" + placement.gate_name + "' in gate body");
+        }
+        placement.gate_id = std::get<size_t>(sym->ir_ref);
+        ir.markGateUsed(placement.gate_id);
+    }
+}
+
+void addGate(GateDef gate, IR& ir, ScopeManager& scopes) {
+    if (scopes.lookupSymbol(gate.name.id())) {
+        return;
+    }
+
+    if (auto* composite = std::get_if<CompositeGateBody>(&gate.semantics)) {
+        resolvePlacements(composite->body, ir, scopes);
+    }
+
+    auto id = ir.addGate(gate);
+    scopes.addSymbol(Symbol{
+        .name = gate.name,
+        .kind = SymbolKind::Gate,
+        .ir_ref = id,
+        .aliases = gate.aliases,
+    });
+}
+
+// parses an included file into the IR, returns what it defined in order
+std::vector<EntryRef> lowerSource(const std::string& path, IR& ir, ScopeManager& scopes) {
+    auto input = MappedCharStream::fromFile(path);
+    qasm3Lexer lexer(input.get());
+    antlr4::CommonTokenStream tokens(&lexer);
+    qasm3Parser parser(&tokens);
+
+    auto parsed = frontend::parseTwoStage(parser, tokens);
+    if (!parsed.tree || parser.getNumberOfSyntaxErrors() > 0) {
+        throw std::runtime_error("Syntax errors in included file: " + path);
+    }
+
+    ProgramCollector collector(ir, scopes);
+    collector.collect_headers = true;
+
+    std::vector<std::pair<bool, std::string>> defined;   // (is include, name)
+    for (auto* statement_or_scope : parsed.tree->statementOrScope()) {
+        auto* statement = statement_or_scope->statement();
+        if (statement && statement->includeStatement()) {
+            auto name = includeName(statement->includeStatement()->StringLiteral()->getText());
+            include(name, ir, scopes);
+            defined.emplace_back(true, name);
+        } else if (statement && statement->gateStatement()) {
+            auto name = statement->gateStatement()->Identifier()->getText();
+            if (scopes.lookupSymbol(name)) {
+                continue;   // same rule as for cached libraries
+            }
+            collector.visit(statement_or_scope);
+            defined.emplace_back(false, name);
+        } else {
+            throw std::runtime_error("Included file " + path
+                                     + " may only contain gate definitions and includes");
+        }
+    }
+    collector.resolveForwardReferences();
+
+    // no gates are added past this point, pointers into the IR stay valid
+    std::vector<EntryRef> entries;
+    for (const auto& [is_include, name] : defined) {
+        if (is_include) {
+            entries.emplace_back(name);
+        } else {
+            entries.emplace_back(&ir.getGate(name));
+        }
+    }
+    return entries;
+}
+
+} // namespace
+
+void configure(Options new_options) {
+    options = std::move(new_options);
+}
+
+bool isStandardInclude(std::string_view name) {
+    return name == "stdgates.inc" || name == "qelib1.inc";
+}
+
+std::string resolveInclude(const std::string& name, const std::string& including_file) {
+    fs::path path(name);
+    if (path.is_absolute()) {
+        if (fs::is_regular_file(path)) {
+            return path.string();
+        }
+    } else {
+        if (!including_file.empty()) {
+            auto candidate = fs::path(including_file).parent_path() / path;
+            if (fs::is_regular_file(candidate)) {
+                return fs::weakly_canonical(candidate).string();
+            }
+        }
+        for (const auto& dir : options.include_dirs) {
+            auto candidate = fs::path(dir) / path;
+            if (fs::is_regular_file(candidate)) {
+                return fs::weakly_canonical(candidate).string();
+            }
+        }
+    }
+    throw std::runtime_error("Cannot find include file: " + name);
+}
+
+std::string includeName(std::string_view literal) {
+    if (literal.size() >= 2 && (literal.front() == '"' || literal.front() == '\'')) {
+        literal = literal.substr(1, literal.size() - 2);
+    }
+    return std::string(literal);
+}
+
+std::vector<GateDef> loadGateTable(const std::string& json_path) {
+    auto stamp = stampOf(json_path);
+    if (stamp && options.use_cache) {
+        if (auto entries = loadLibrary(libraryPath(json_path), *stamp)) {
+            std::vector<GateDef> gates;
+            gates.reserve(entries->size());
+            for (auto& entry : *entries) {
+                if (auto* gate = std::get_if<GateDef>(&entry)) {
+                    gates.push_back(std::move(*gate));
+                }
+            }
+            return gates;
+        }
+    }
+
+    auto gates = loadGates(json_path, options.algebraic, options.precision);
+
+    if (stamp && options.use_cache) {
+        std::vector<EntryRef> entries;
+        for (const auto& gate : gates) {
+            entries.emplace_back(&gate);
+        }
+        saveLibrary(libraryPath(json_path), *stamp, entries);
+    }
+    return gates;
+}
+
+void include(const std::string& name, IR& ir, ScopeManager& scopes) {
+    if (isStandardInclude(name)) {
+        return;   // provided by the builtin gate table
+    }
+
+    // nested includes are relative to the file including them
+    const std::string path = resolveInclude(name, include_stack.empty() ? "" : include_stack.back());
+    if (std::find(include_stack.begin(), include_stack.end(), path) != include_stack.end()) {
+        throw std::runtime_error("Circular include of " + path);
+    }
+
+    include_stack.push_back(path);
+    try {
+        auto stamp = stampOf(path);
+        std::optional<std::vector<Entry>> cached;
+        if (stamp && options.use_cache) {
+            cached = loadLibrary(libraryPath(path), *stamp);
+        }
+
+        if (cached) {
+            for (auto& entry : *cached) {
+                if (auto* nested = std::get_if<std::string>(&entry)) {
+                    include(*nested, ir, scopes);
+                } else {
+                    addGate(std::move(std::get<GateDef>(entry)), ir, scopes);
+                }
+            }
+        } else {
+            auto entries = lowerSource(path, ir, scopes);
+            if (stamp && options.use_cache) {
+                saveLibrary(libraryPath(path), *stamp, entries);
+            }
+        }
+    } catch (...) {
+        include_stack.pop_back();
+        throw;
+    }
+    include_stack.pop_back();
+}
+
+} // namespace gate_library
+
+/* EOF GateLibrary.cpp */
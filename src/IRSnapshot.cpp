@@ -0,0 +1,461 @@
+/**
+ * @file IRSnapshot.cpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ *
+ * Snapshot layout (little endian, see Serialize.hpp):
+ *
+ *   "QFIR" u32 version
+ *   u32 register count, registers: u64 id, name, u8 kind, u8 type, size
+ *   u32 gate count, gates: u64 id, gate (see GateLibrary.hpp), u8 used
+ *   u32 subroutine count, subroutines:
+ *     u64 id, name, u32 count + parameters (name, type, u8 passing, u8 mutability),
+ *     u8 has return type [+ return type], u8 extern, u8 used, block
+ *   global block
+ *
+ *   block: u32 count + variables, nodes
+ *   variable: name, type, u8 const, compile time value, initializer
+ *   type: base, dims, u8 const
+ *   nodes: u32 count, u8 NodeKind + node:
+ *     gate:        u64 gate id, u32 count + operands (u64 register, index), params
+ *     loop:        type, variable, u8 values kind + values, block
+ *     conditional: condition, nodes (then), nodes (else)
+ *     stream:      arrays gates, operand_offsets, operand_regs,
+ *                  operand_indices, param_offsets (u64 count + raw
+ *                  elements each), u32 count + params
+ *   index: i64 scale, u8 has symbol [+ symbol name], i64 offset, opaque
+ */
+
+#include "../inc/IRSnapshot.hpp"
+#include "../inc/GateLibrary.hpp"
+#include "../inc/MappedCharStream.hpp"
+#include "../inc/Serialize.hpp"
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+namespace ir_snapshot {
+
+namespace {
+
+constexpr std::string_view MAGIC = "QFIR";
+constexpr std::uint32_t FORMAT_VERSION = 2;
+
+enum : std::uint8_t { INTERVAL_VALUES = 0, LIST_VALUES = 1, EXPRESSION_VALUES = 2 };
+
+// ---- writing ----
+
+// stream arrays are written as they lie in memory, so loading is one copy
+template <typename T>
+void writeArray(serialize::Writer& out, const std::pmr::vector<T>& values) {
+    out.u64(values.size());
+    if constexpr (std::endian::native == std::endian::little) {
+        out.raw(std::string_view(reinterpret_cast<const char*>(values.data()),
+                                 values.size() * sizeof(T)));
+    } else {
+        for (auto value : values) {
+            out.u32(static_cast<std::uint32_t>(value));
+        }
+    }
+}
+
+void writeType(serialize::Writer& out, const TypeExpr& type) {
+    out.string(type.base);
+    out.strings(type.dims);
+    out.u8(type.is_const);
+}
+
+void writeIndex(serialize::Writer& out, const IndexExpr& index) {
+    out.i64(index.scale);
+    out.u8(index.symbol.has_value());
+    if (index.symbol) {
+        out.string(symbolName(*index.symbol));   // ids are only valid in this process
+    }
+    out.i64(index.offset);
+    out.string(index.opaque);
+}
+
+void writeBlock(serialize::Writer& out, const Block& block);
+
+void writeNodes(serialize::Writer& out, const std::vector<ProgramNodePtr>& nodes) {
+    out.u32(static_cast<std::uint32_t>(nodes.size()));
+    for (const auto& node : nodes) {
+        out.u8(static_cast<std::uint8_t>(node->kind));
+        switch (node->kind) {
+            case NodeKind::Gate: {
+                const auto& app = static_cast<const GateApplication&>(*node);
+                out.u64(app.gate_id);
+                out.u32(static_cast<std::uint32_t>(app.operands.size()));
+                for (const auto& op : app.operands) {
+                    out.u64(op.reg_id);
+                    writeIndex(out, op.index);
+                }
+                out.u32(static_cast<std::uint32_t>(app.params.size()));
+                for (const auto& param : app.params) {
+                    out.string(param);
+                }
+                break;
+            }
+            case NodeKind::Loop: {
+                const auto& loop = static_cast<const LoopApplication&>(*node);
+                writeType(out, loop.type);
+                out.string(loop.variable);
+                if (const auto* interval = std::get_if<Interval>(&loop.values)) {
+                    out.u8(INTERVAL_VALUES);
+                    out.string(interval->start);
+                    out.string(interval->step);
+                    out.string(interval->end);
+                } else if (const auto* list = std::get_if<std::vector<std::string>>(&loop.values)) {
+                    out.u8(LIST_VALUES);
+                    out.strings(*list);
+                } else {
+                    out.u8(EXPRESSION_VALUES);
+                    out.string(std::get<std::string>(loop.values));
+                }
+                writeBlock(out, loop.body);
+                break;
+            }
+            case NodeKind::Conditional: {
+                const auto& cond = static_cast<const ConditionalApplication&>(*node);
+                out.string(cond.condition_expr);
+                writeNodes(out, cond.then_body);
+                writeNodes(out, cond.else_body);
+                break;
+            }
+            case NodeKind::Stream: {
+                const auto& stream = static_cast<const GateStream&>(*node);
+                writeArray(out, stream.gates);
+                writeArray(out, stream.operand_offsets);
+                writeArray(out, stream.operand_regs);
+                writeArray(out, stream.operand_indices);
+                writeArray(out, stream.param_offsets);
+                out.u32(static_cast<std::uint32_t>(stream.params.size()));
+                for (const auto& param : stream.params) {
+                    out.string(param);
+                }
+                break;
+            }
+        }
+    }
+}
+
+void writeBlock(serialize::Writer& out, const Block& block) {
+    out.u32(static_cast<std::uint32_t>(block.variables.size()));
+    for (const auto& var : block.variables) {
+        out.string(var.name);
+        writeType(out, var.type);
+        out.u8(var.is_const);
+        out.string(var.compile_time_value);
+        out.string(var.initializer);
+    }
+    writeNodes(out, block.body);
+}
+
+// ---- reading ----
+
+template <typename T>
+void readArray(serialize::Reader& in, std::pmr::vector<T>& values) {
+    const std::uint64_t count = in.u64();
+    if constexpr (std::endian::native == std::endian::little) {
+        auto bytes = in.raw(count * sizeof(T));   // throws before the resize if truncated
+        values.resize(count);
+        std::memcpy(values.data(), bytes.data(), bytes.size());
+    } else {
+        values.clear();
+        for (std::uint64_t i = 0; i < count; ++i) {
+            values.push_back(static_cast<T>(in.u32()));
+        }
+    }
+}
+
+// a string viewed in the mapped file, copied only into its final storage
+std::string_view readView(serialize::Reader& in) {
+    return in.raw(in.u32());
+}
+
+TypeExpr readType(serialize::Reader& in) {
+    TypeExpr type;
+    type.base = in.string();
+    type.dims = in.strings();
+    type.is_const = in.u8() != 0;
+    return type;
+}
+
+IndexExpr readIndex(serialize::Reader& in) {
+    IndexExpr index;
+    index.scale = in.i64();
+    if (in.u8() != 0) {
+        index.symbol = intern(readView(in));
+    }
+    index.offset = in.i64();
+    index.opaque = in.string();
+    return index;
+}
+
+void readBlock(serialize::Reader& in, Block& block, IR& ir);
+
+void checkStream(const GateStream& stream, const IR& ir) {
+    const bool consistent =
+        stream.operand_offsets.size() == stream.size() + 1
+        && stream.param_offsets.size() == stream.size() + 1
+        && stream.operand_regs.size() == stream.operand_indices.size()
+        && stream.operand_offsets.back() == stream.operand_regs.size()
+        && stream.param_offsets.back() == stream.params.size();
+    if (!consistent) {
+        throw std::runtime_error("Corrupt gate stream");
+    }
+    for (auto gate : stream.gates) {
+        if (!ir.getAllGates().contains(gate)) {
+            throw std::runtime_error("Invalid gate id in gate stream");
+        }
+    }
+    for (auto reg : stream.operand_regs) {
+        if (!ir.getAllRegisters().contains(reg)) {
+            throw std::runtime_error("Invalid register id in gate stream");
+        }
+    }
+}
+
+void readNodes(serialize::Reader& in, std::vector<ProgramNodePtr>& nodes, IR& ir) {
+    const std::uint32_t count = in.u32();
+    nodes.reserve(nodes.size() + count);
+    for (std::uint32_t i = 0; i < count; ++i) {
+        const auto kind = static_cast<NodeKind>(in.u8());
+        switch (kind) {
+            case NodeKind::Gate: {
+                auto app = makeNode<GateApplication>(ir.arena());
+                app->gate_id = in.u64();
+                if (!ir.getAllGates().contains(app->gate_id)) {
+                    throw std::runtime_error("Invalid gate id in gate application");
+                }
+                const std::uint32_t operands = in.u32();
+                app->operands.reserve(operands);
+                for (std::uint32_t k = 0; k < operands; ++k) {
+                    const idRegister reg_id = in.u64();
+                    if (!ir.getAllRegisters().contains(reg_id)) {
+                        throw std::runtime_error("Invalid register id in gate application");
+                    }
+                    app->operands.push_back(RegisterRef{reg_id, readIndex(in)});
+                }
+                const std::uint32_t params = in.u32();
+                app->params.reserve(params);
+                for (std::uint32_t k = 0; k < params; ++k) {
+                    app->params.emplace_back(readView(in));
+                }
+                nodes.push_back(std::move(app));
+                break;
+            }
+            case NodeKind::Loop: {
+                auto loop = makeNode<LoopApplication>(ir.arena());
+                loop->type = readType(in);
+                loop->variable = in.string();
+                const std::uint8_t values = in.u8();
+                if (values == INTERVAL_VALUES) {
+                    Interval interval;
+                    interval.start = in.string();
+                    interval.step = in.string();
+                    interval.end = in.string();
+                    loop->values = std::move(interval);
+                } else if (values == LIST_VALUES) {
+                    loop->values = in.strings();
+                } else if (values == EXPRESSION_VALUES) {
+                    loop->values = in.string();
+                } else {
+                    throw std::runtime_error("Corrupt loop values");
+                }
+                readBlock(in, loop->body, ir);
+                nodes.push_back(std::move(loop));
+                break;
+            }
+            case NodeKind::Conditional: {
+                auto cond = makeNode<ConditionalApplication>(ir.arena());
+                cond->condition_expr = in.string();
+                readNodes(in, cond->then_body, ir);
+                readNodes(in, cond->else_body, ir);
+                nodes.push_back(std::move(cond));
+                break;
+            }
+            case NodeKind::Stream: {
+                auto stream = makeNode<GateStream>(ir.arena());
+                readArray(in, stream->gates);
+                readArray(in, stream->operand_offsets);
+                readArray(in, stream->operand_regs);
+                readArray(in, stream->operand_indices);
+                readArray(in, stream->param_offsets);
+                const std::uint32_t params = in.u32();
+                stream->params.reserve(params);
+                for (std::uint32_t k = 0; k < params; ++k) {
+                    stream->params.emplace_back(readView(in));
+                }
+                checkStream(*stream, ir);
+                nodes.push_back(std::move(stream));
+                break;
+            }
+            default:
+                throw std::runtime_error("Corrupt program node");
+        }
+    }
+}
+
+void readBlock(serialize::Reader& in, Block& block, IR& ir) {
+    const std::uint32_t variables = in.u32();
+    block.variables.reserve(variables);
+    for (std::uint32_t i = 0; i < variables; ++i) {
+        VariableDef var;
+        var.name = in.string();
+        var.type = readType(in);
+        var.is_const = in.u8() != 0;
+        var.compile_time_value = in.string();
+        var.initializer = in.string();
+        block.variables.push_back(std::move(var));
+    }
+    readNodes(in, block.body, ir);
+}
+
+// composite bodies refer to gates by name in the gate format
+void resolvePlacements(std::vector<GateStmt>& body, const IR& ir) {
+    for (auto& stmt : body) {
+        if (auto* loop = std::get_if<RepeatBlock>(&stmt)) {
+            resolvePlacements(loop->body, ir);
+        } else {
+            auto& placement = std::get<GatePlacement>(stmt);
+            placement.gate_id = ir.getGateId(placement.gate_name);
+        }
+    }
+}
+
+} // namespace
+
+void save(const IR& ir, const std::string& path) {
+    serialize::Writer out;
+    out.raw(MAGIC);
+    out.u32(FORMAT_VERSION);
+
+    // ids are stored as they are, slots of removed entries stay free on load
+    const auto& registers = ir.getAllRegisters();
+    out.u32(static_cast<std::uint32_t>(registers.size()));
+    for (auto it = registers.begin(); it != registers.end(); ++it) {
+        const auto& reg = *it;
+        out.u64(it.id());
+        out.string(reg.name.view());
+        out.u8(static_cast<std::uint8_t>(reg.kind));
+        out.u8(static_cast<std::uint8_t>(reg.type));
+        out.string(reg.size);
+    }
+
+    const auto& gates = ir.getAllGates();
+    out.u32(static_cast<std::uint32_t>(gates.size()));
+    for (auto it = gates.begin(); it != gates.end(); ++it) {
+        const auto& gate = *it;
+        out.u64(it.id());
+        gate_library::writeGate(out, gate);
+        out.u8(gate.used);
+    }
+
+    const auto& subroutines = ir.getAllSubroutines();
+    out.u32(static_cast<std::uint32_t>(subroutines.size()));
+    for (auto it = subroutines.begin(); it != subroutines.end(); ++it) {
+        const auto& sub = *it;
+        out.u64(it.id());
+        out.string(sub.name.view());
+        out.u32(static_cast<std::uint32_t>(sub.parameters.size()));
+        for (const auto& param : sub.parameters) {
+            out.string(param.name);
+            out.string(param.type);
+            out.u8(static_cast<std::uint8_t>(param.passing));
+            out.u8(static_cast<std::uint8_t>(param.mutability));
+        }
+        out.u8(sub.return_type.has_value());
+        if (sub.return_type) {
+            out.string(*sub.return_type);
+        }
+        out.u8(sub.is_extern);
+        out.u8(sub.used);
+        writeBlock(out, sub.body);
+    }
+
+    writeBlock(out, ir.getGlobalBlock());
+
+    if (!serialize::writeFileAtomically(path, out.bytes())) {
+        throw std::runtime_error("Cannot write IR snapshot: " + path);
+    }
+}
+
+void load(const std::string& path, IR& ir) {
+    if (ir.registerCount() > 0 || ir.gateCount() > 0 || !ir.getGlobalBlock().body.empty()) {
+        throw std::logic_error("IR snapshots can only be loaded into an empty IR");
+    }
+
+    auto mapped = MappedCharStream::fromFile(path);
+    serialize::Reader in(mapped->contents());
+
+    try {
+        if (in.raw(MAGIC.size()) != MAGIC) {
+            throw std::runtime_error("not an IR snapshot");
+        }
+        if (in.u32() != FORMAT_VERSION) {
+            throw std::runtime_error("unsupported format version");
+        }
+
+        const std::uint32_t registers = in.u32();
+        for (std::uint32_t i = 0; i < registers; ++i) {
+            const std::size_t id = in.u64();
+            RegisterDef reg;
+            reg.name = in.string();
+            reg.kind = static_cast<RegisterKind>(in.u8());
+            reg.type = static_cast<RegisterType>(in.u8());
+            reg.size = in.string();
+            ir.addRegisterAt(id, reg);
+        }
+
+        const std::uint32_t gates = in.u32();
+        std::vector<std::size_t> gate_ids;
+        for (std::uint32_t i = 0; i < gates; ++i) {
+            const std::size_t id = in.u64();
+            GateDef gate = gate_library::readGate(in);
+            gate.used = in.u8() != 0;
+            ir.addGateAt(id, gate);
+            gate_ids.push_back(id);
+        }
+        for (auto id : gate_ids) {
+            if (auto* composite = std::get_if<CompositeGateBody>(&ir.getGate(id).semantics)) {
+                resolvePlacements(composite->body, ir);
+            }
+        }
+
+        const std::uint32_t subroutines = in.u32();
+        for (std::uint32_t i = 0; i < subroutines; ++i) {
+            const std::size_t id = in.u64();
+            SubroutineDef sub;
+            sub.name = in.string();
+            const std::uint32_t params = in.u32();
+            for (std::uint32_t k = 0; k < params; ++k) {
+                ParameterDef param;
+                param.name = in.string();
+                param.type = in.string();
+                param.passing = static_cast<ParamPassing>(in.u8());
+                param.mutability = static_cast<ParamMutability>(in.u8());
+                sub.parameters.push_back(std::move(param));
+            }
+            if (in.u8() != 0) {
+                sub.return_type = in.string();
+            }
+            sub.is_extern = in.u8() != 0;
+            sub.used = in.u8() != 0;
+            readBlock(in, sub.body, ir);
+            ir.addSubroutineAt(id, std::move(sub));
+        }
+
+        readBlock(in, ir.getGlobalBlock(), ir);
+
+        if (!in.atEnd()) {
+            throw std::runtime_error("trailing data");
+        }
+    } catch (const std::runtime_error& e) {
+        throw std::runtime_error("Invalid IR snapshot " + path + ": " + e.what());
+    }
+}
+
+} // namespace ir_snapshot
+
+/* EOF IRSnapshot.cpp */
@@ -0,0 +1,64 @@
+/**
+ * @file Interner.cpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ */
+
+#include "../inc/Interner.hpp"
+#include <mutex>
+#include <stdexcept>
+
+Interner& Interner::global() {
+    static Interner instance;
+    return instance;
+}
+
+SymbolId Interner::intern(std::string_view name) {
+    {
+        std::shared_lock lock(_mutex);
+        auto it = _ids.find(name);
+        if (it != _ids.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock lock(_mutex);
+    // another thread may have added it in between
+    auto it = _ids.find(name);
+    if (it != _ids.end()) {
+        return it->second;
+    }
+
+    const auto id = static_cast<SymbolId>(_names.size());
+    const std::string& stored = _names.emplace_back(name);
+    _ids.emplace(stored, id);
+    return id;
+}
+
+std::optional<SymbolId> Interner::find(std::string_view name) const {
+    std::shared_lock lock(_mutex);
+    auto it = _ids.find(name);
+    if (it == _ids.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+std::string_view Interner::name(SymbolId id) const {
+    return text(id);
+}
+
+const std::string& Interner::text(SymbolId id) const {
+    std::shared_lock lock(_mutex);
+    if (id >= _names.size()) {
+        throw std::out_of_range("Invalid symbol id");
+    }
+    return _names[id];
+}
+
+std::size_t Interner::size() const {
+    std::shared_lock lock(_mutex);
+    return _names.size();
+}
+
+/* EOF Interner.cpp */
@@ -0,0 +1,241 @@
+/**
+ * @file MappedCharStream.cpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ */
+
+#include "../inc/MappedCharStream.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedCharStream::MappedCharStream(std::string source_name)
+    : _source_name(std::move(source_name)) {}
+
+MappedCharStream::~MappedCharStream() {
+    if (_mapping) {
+        munmap(_mapping, _size);
+    }
+}
+
+std::unique_ptr<MappedCharStream> MappedCharStream::fromFile(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open file: " + path);
+    }
+
+    try {
+        auto stream = fromDescriptor(fd, path);
+        close(fd);
+        return stream;
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+}
+
+std::unique_ptr<MappedCharStream> MappedCharStream::fromStdin() {
+    return fromDescriptor(STDIN_FILENO, "<stdin>");
+}
+
+std::unique_ptr<MappedCharStream> MappedCharStream::fromDescriptor(int fd, std::string source_name) {
+    std::unique_ptr<MappedCharStream> stream(new MappedCharStream(std::move(source_name)));
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        throw std::runtime_error("Could not stat input: " + stream->_source_name);
+    }
+
+    // regular files are mapped, the mapping outlives the descriptor
+    if (S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            madvise(mapping, st.st_size, MADV_SEQUENTIAL);
+            stream->_mapping = mapping;
+            stream->_data = static_cast<const char*>(mapping);
+            stream->_size = static_cast<size_t>(st.st_size);
+            return stream;
+        }
+        // fall through to reading, e.g. on filesystems without mmap support
+    }
+
+    // pipes and terminals: one bulk read into a growing buffer, no iostreams
+    std::string& buffer = stream->_buffer;
+    size_t length = 0;
+    buffer.resize(S_ISREG(st.st_mode) && st.st_size > 0 ? st.st_size : (1 << 20));
+
+    for (;;) {
+        if (length == buffer.size()) {
+            buffer.resize(buffer.size() * 2);
+        }
+        ssize_t n = read(fd, buffer.data() + length, buffer.size() - length);
+        if (n == 0) {
+            break;
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("Error reading input " + stream->_source_name
+                                     + ": " + std::strerror(errno));
+        }
+        length += static_cast<size_t>(n);
+    }
+    buffer.resize(length);
+    buffer.shrink_to_fit();
+
+    stream->_data = buffer.data();
+    stream->_size = buffer.size();
+    return stream;
+}
+
+size_t MappedCharStream::decodeAt(size_t pos, size_t& len) const {
+    const unsigned char lead = static_cast<unsigned char>(_data[pos]);
+    len = 1;
+
+    if (lead < 0x80) {
+        return lead;
+    }
+
+    size_t continuation;
+    size_t code_point;
+    if ((lead & 0xE0) == 0xC0) {
+        continuation = 1;
+        code_point = lead & 0x1F;
+    } else if ((lead & 0xF0) == 0xE0) {
+        continuation = 2;
+        code_point = lead & 0x0F;
+    } else if ((lead & 0xF8) == 0xF0) {
+        continuation = 3;
+        code_point = lead & 0x07;
+    } else {
+        return lead; // stray continuation byte, passed through as Latin-1
+    }
+
+    if (pos + continuation >= _size) {
+        return lead; // truncated sequence at end of input
+    }
+
+    for (size_t k = 1; k <= continuation; ++k) {
+        const unsigned char byte = static_cast<unsigned char>(_data[pos + k]);
+        if ((byte & 0xC0) != 0x80) {
+            return lead; // malformed sequence
+        }
+        code_point = (code_point << 6) | (byte & 0x3F);
+    }
+
+    len = continuation + 1;
+    return code_point;
+}
+
+void MappedCharStream::consume() {
+    if (_pos >= _size) {
+        throw antlr4::IllegalStateException("cannot consume EOF");
+    }
+    size_t len;
+    decodeAt(_pos, len);
+    _pos += len;
+}
+
+size_t MappedCharStream::LA(ssize_t i) {
+    if (i == 0) {
+        return 0; // undefined
+    }
+
+    size_t pos = _pos;
+    size_t len;
+
+    if (i > 0) {
+        for (ssize_t k = 1; k < i; ++k) {
+            if (pos >= _size) {
+                return antlr4::IntStream::EOF;
+            }
+            decodeAt(pos, len);
+            pos += len;
+        }
+        if (pos >= _size) {
+            return antlr4::IntStream::EOF;
+        }
+        return decodeAt(pos, len);
+    }
+
+    // look behind: step back over continuation bytes
+    for (ssize_t k = 0; k < -i; ++k) {
+        if (pos == 0) {
+            return antlr4::IntStream::EOF;
+        }
+        do {
+            --pos;
+        } while (pos > 0 && (static_cast<unsigned char>(_data[pos]) & 0xC0) == 0x80);
+    }
+    return decodeAt(pos, len);
+}
+
+ssize_t MappedCharStream::mark() {
+    return -1; // whole input is always available
+}
+
+void MappedCharStream::release(ssize_t /*marker*/) {}
+
+size_t MappedCharStream::index() {
+    return _pos;
+}
+
+void MappedCharStream::seek(size_t index) {
+    _pos = std::min(index, _size);
+}
+
+size_t MappedCharStream::size() {
+    return _size;
+}
+
+std::string MappedCharStream::getSourceName() const {
+    return _source_name;
+}
+
+std::string_view MappedCharStream::view(size_t start, size_t stop) const {
+    if (start >= _size || stop < start) {
+        return {};
+    }
+    stop = std::min(stop, _size - 1);
+    return std::string_view(_data + start, stop - start + 1);
+}
+
+std::string MappedCharStream::getText(const antlr4::misc::Interval& interval) {
+    if (interval.a < 0 || interval.b < interval.a) {
+        return "";
+    }
+    return std::string(view(static_cast<size_t>(interval.a), static_cast<size_t>(interval.b)));
+}
+
+std::unique_ptr<MappedCharStream> MappedCharStream::slice(size_t start, size_t stop) const {
+    std::unique_ptr<MappedCharStream> stream(new MappedCharStream(_source_name));
+    start = std::min(start, _size);
+    stop = std::clamp(stop, start, _size);
+    stream->_data = _data + start;
+    stream->_size = stop - start;
+    return stream;
+}
+
+void MappedCharStream::releaseBefore(size_t index) {
+    if (!_mapping) {
+        return;
+    }
+
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t end = std::min(index, _size) / page * page;
+    if (end > _released) {
+        madvise(static_cast<char*>(_mapping) + _released, end - _released, MADV_DONTNEED);
+        _released = end;
+    }
+}
+
+std::string MappedCharStream::toString() const {
+    return std::string(_data, _size);
+}
+
+/* EOF MappedCharStream.cpp */
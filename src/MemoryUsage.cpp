@@ -0,0 +1,43 @@
+/**
+ * @file MemoryUsage.cpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ */
+
+#include "../inc/MemoryUsage.hpp"
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace memory {
+
+Usage current() {
+    Usage usage;
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        // lines look like "VmRSS:     1234 kB"
+        std::istringstream fields(line);
+        std::string key;
+        std::size_t value = 0;
+        fields >> key >> value;
+        if (key == "VmRSS:") {
+            usage.rss_kb = value;
+        } else if (key == "VmHWM:") {
+            usage.peak_kb = value;
+        }
+    }
+    return usage;
+}
+
+bool resetPeak() {
+    // "5" resets VmHWM to the current RSS (Linux 4.0+)
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+    clear_refs.flush();
+    return clear_refs.good();
+}
+
+} // namespace memory
+
+/* EOF MemoryUsage.cpp */
@@ -0,0 +1,336 @@
+/**
+ * @file OutputCache.cpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ */
+
+#include "../inc/OutputCache.hpp"
+#include "../inc/GateLibrary.hpp"
+#include "../inc/Serialize.hpp"
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// bump when the key layout changes
+constexpr std::string_view KEY_VERSION = "qfront output cache 4";
+constexpr std::string_view GATE_TABLE = "json_gates/gates.json";
+
+// two seeds give a 128-bit key, ample for a cache of any practical size
+constexpr std::uint64_t SEED_LOW = 0;
+constexpr std::uint64_t SEED_HIGH = 0x51'7c'c1'b7'27'22'0a'95;
+
+// ---- xxHash64 ----
+
+constexpr std::uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+constexpr std::uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr std::uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+constexpr std::uint64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+constexpr std::uint64_t PRIME5 = 0x27D4EB2F165667C5ULL;
+
+template <typename T>
+T load(const char* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+std::uint64_t mixRound(std::uint64_t acc, std::uint64_t input) {
+    acc += input * PRIME2;
+    acc = std::rotl(acc, 31);
+    return acc * PRIME1;
+}
+
+std::uint64_t mergeRound(std::uint64_t acc, std::uint64_t value) {
+    acc ^= mixRound(0, value);
+    return acc * PRIME1 + PRIME4;
+}
+
+std::uint64_t hash64(std::string_view data, std::uint64_t seed) {
+    const char* p = data.data();
+    const char* const end = p + data.size();
+    std::uint64_t h;
+
+    if (data.size() >= 32) {
+        std::uint64_t v1 = seed + PRIME1 + PRIME2;
+        std::uint64_t v2 = seed + PRIME2;
+        std::uint64_t v3 = seed;
+        std::uint64_t v4 = seed - PRIME1;
+        for (; end - p >= 32; p += 32) {
+            v1 = mixRound(v1, load<std::uint64_t>(p));
+            v2 = mixRound(v2, load<std::uint64_t>(p + 8));
+            v3 = mixRound(v3, load<std::uint64_t>(p + 16));
+            v4 = mixRound(v4, load<std::uint64_t>(p + 24));
+        }
+        h = std::rotl(v1, 1) + std::rotl(v2, 7) + std::rotl(v3, 12) + std::rotl(v4, 18);
+        h = mergeRound(h, v1);
+        h = mergeRound(h, v2);
+        h = mergeRound(h, v3);
+        h = mergeRound(h, v4);
+    } else {
+        h = seed + PRIME5;
+    }
+    h += data.size();
+
+    for (; end - p >= 8; p += 8) {
+        h ^= mixRound(0, load<std::uint64_t>(p));
+        h = std::rotl(h, 27) * PRIME1 + PRIME4;
+    }
+    if (end - p >= 4) {
+        h ^= static_cast<std::uint64_t>(load<std::uint32_t>(p)) * PRIME1;
+        h = std::rotl(h, 23) * PRIME2 + PRIME3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= static_cast<std::uint64_t>(static_cast<unsigned char>(*p)) * PRIME5;
+        h = std::rotl(h, 11) * PRIME1;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+void hashInto(serialize::Writer& out, std::string_view data) {
+    out.u64(data.size());
+    out.u64(hash64(data, SEED_LOW));
+    out.u64(hash64(data, SEED_HIGH));
+}
+
+std::string hex(std::uint64_t value) {
+    static constexpr char DIGITS[] = "0123456789abcdef";
+    std::string text(16, '0');
+    for (int i = 15; i >= 0; --i, value >>= 4) {
+        text[i] = DIGITS[value & 0xF];
+    }
+    return text;
+}
+
+// the binary itself stands for the version, any rebuild starts a new cache
+std::uint64_t buildId() {
+    static const std::uint64_t id = [] {
+        try {
+            auto exe = MappedCharStream::fromFile("/proc/self/exe");
+            return hash64(exe->contents(), SEED_LOW);
+        } catch (const std::runtime_error&) {
+            return hash64(__DATE__ " " __TIME__, SEED_LOW);
+        }
+    }();
+    return id;
+}
+
+bool isIdentifierChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+/**
+ * Adds the contents of the files included by source, recursively. The scan
+ * is textual, an `include` in a comment only costs a file read.
+ * Returns false if an included file cannot be found or read.
+ */
+bool hashIncludes(std::string_view source, const std::string& source_path,
+                  serialize::Writer& out, std::vector<std::string>& seen) {
+    constexpr std::string_view KEYWORD = "include";
+    for (auto pos = source.find(KEYWORD); pos != std::string_view::npos;
+         pos = source.find(KEYWORD, pos + KEYWORD.size())) {
+        if (pos > 0 && isIdentifierChar(source[pos - 1])) {
+            continue;
+        }
+        auto open = pos + KEYWORD.size();
+        while (open < source.size() && std::isspace(static_cast<unsigned char>(source[open]))) {
+            ++open;
+        }
+        if (open >= source.size() || (source[open] != '"' && source[open] != '\'')) {
+            continue;
+        }
+        const auto close = source.find(source[open], open + 1);
+        if (close == std::string_view::npos) {
+            continue;
+        }
+
+        const auto name = gate_library::includeName(source.substr(open, close - open + 1));
+        if (gate_library::isStandardInclude(name)) {
+            continue;
+        }
+        try {
+            auto path = gate_library::resolveInclude(name, source_path);
+            if (std::find(seen.begin(), seen.end(), path) != seen.end()) {
+                continue;
+            }
+            seen.push_back(path);
+
+            auto included = MappedCharStream::fromFile(path);
+            out.string(path);
+            hashInto(out, included->contents());
+            if (!hashIncludes(included->contents(), path, out, seen)) {
+                return false;
+            }
+        } catch (const std::runtime_error&) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool isEntryName(const std::string& name) {
+    return name.size() == 32
+        && std::all_of(name.begin(), name.end(), [](char c) { return std::isxdigit(static_cast<unsigned char>(c)); });
+}
+
+} // namespace
+
+OutputCache::OutputCache(std::string dir, std::uint64_t max_bytes)
+    : _dir(std::move(dir)), _max_bytes(max_bytes) {
+    std::error_code error;
+    fs::create_directories(_dir, error);
+    if (!fs::is_directory(_dir)) {
+        throw std::runtime_error("Cannot create cache directory: " + _dir);
+    }
+}
+
+std::optional<std::string> OutputCache::key(std::string_view input, const ArgParser::Args& args) const {
+    serialize::Writer out;
+    out.string(KEY_VERSION);
+    out.u64(buildId());
+
+    // options that change the output; the parser choice (fast path, two-pass,
+    // jobs) does not, but a streamed run lays out its output differently
+    out.string(args.target);
+    out.u8(args.stream);
+    out.u8(args.use_algebraic);
+    out.u32(args.algebraic_precision);
+    out.string(args.passes);   // the pass options are folded into it
+    out.u64(args.unroll_budget);
+    out.u32(args.unroll_factor);
+
+    try {
+        auto gates = MappedCharStream::fromFile(std::string(GATE_TABLE));
+        hashInto(out, gates->contents());
+    } catch (const std::runtime_error&) {
+        return std::nullopt;
+    }
+
+    std::vector<std::string> seen;
+    // the program's own includes go through the include directories
+    if (!hashIncludes(input, "", out, seen)) {
+        return std::nullopt;
+    }
+    hashInto(out, input);
+
+    return hex(hash64(out.bytes(), SEED_HIGH)) + hex(hash64(out.bytes(), SEED_LOW));
+}
+
+std::string OutputCache::entryPath(const std::string& key) const {
+    return (fs::path(_dir) / key).string();
+}
+
+std::unique_ptr<MappedCharStream> OutputCache::fetch(const std::string& key) {
+    const auto path = entryPath(key);
+    std::unique_ptr<MappedCharStream> entry;
+    try {
+        if (fs::is_regular_file(path)) {
+            entry = MappedCharStream::fromFile(path);
+        }
+    } catch (const std::runtime_error&) {
+        // evicted by another process in the meantime
+    }
+
+    if (!entry) {
+        ++_stats.misses;
+        return nullptr;
+    }
+
+    // recently used entries are evicted last
+    std::error_code error;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+    ++_stats.hits;
+    return entry;
+}
+
+void OutputCache::store(const std::string& key, std::string_view output) {
+    if (output.size() > _max_bytes) {
+        return;
+    }
+    if (!serialize::writeFileAtomically(entryPath(key), output)) {
+        return;
+    }
+    ++_stats.stored;
+
+    if (!_total) {
+        scan();   // sees the new entry already
+    } else {
+        auto& size = _sizes[key];   // a rewritten entry replaces its old size
+        *_total += output.size() - size;
+        size = output.size();
+    }
+    if (*_total > _max_bytes) {
+        evict();
+    }
+}
+
+void OutputCache::storeFile(const std::string& key, const std::string& path) {
+    try {
+        auto output = MappedCharStream::fromFile(path);
+        store(key, output->contents());
+    } catch (const std::runtime_error&) {
+        // nothing to store
+    }
+}
+
+std::vector<OutputCache::Entry> OutputCache::scan() {
+    std::vector<Entry> entries;
+    std::uint64_t total = 0;
+    _sizes.clear();
+
+    std::error_code error;
+    for (const auto& file : fs::directory_iterator(_dir, error)) {
+        auto name = file.path().filename().string();
+        if (!file.is_regular_file(error) || !isEntryName(name)) {
+            continue;
+        }
+        Entry entry{file.last_write_time(error), file.file_size(error), std::move(name)};
+        if (!error) {
+            total += entry.size;
+            _sizes[entry.key] = entry.size;
+            entries.push_back(std::move(entry));
+        }
+    }
+    _total = total;
+    return entries;
+}
+
+void OutputCache::evict() {
+    auto entries = scan();
+    if (*_total <= _max_bytes) {
+        return;
+    }
+
+    // down to a low-water mark, so the next stores do not scan again right away
+    const std::uint64_t target = _max_bytes - _max_bytes / 10;
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) { return a.used < b.used; });
+    std::error_code error;
+    for (const auto& entry : entries) {
+        if (*_total <= target) {
+            break;
+        }
+        // another process may have removed it already, the space is free either way
+        fs::remove(entryPath(entry.key), error);
+        *_total -= entry.size;
+        _sizes.erase(entry.key);
+        ++_stats.evicted;
+        _stats.evicted_bytes += entry.size;
+    }
+}
+
+/* EOF OutputCache.cpp */
@@ -0,0 +1,299 @@
+/**
+ * @file ParallelFrontend.cpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ */
+
+#include "../inc/ParallelFrontend.hpp"
+#include "../inc/Frontend.hpp"
+#include "../inc/visitors/GateHeadersCollector.hpp"
+#include "../inc/visitors/ProgramCollector.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <unordered_set>
+
+// below this a chunk costs more in thread and parser setup than it saves
+static constexpr size_t MIN_CHUNK_SIZE = 256 * 1024;
+
+namespace frontend {
+
+std::vector<Chunk> splitTopLevel(std::string_view source, size_t count, size_t min_size) {
+    std::vector<Chunk> chunks;
+    const size_t n = source.size();
+    const size_t target = std::max(min_size, n / std::max<size_t>(count, 1) + 1);
+
+    // newlines inside a skipped range still count for line numbers
+    auto skipTo = [&](size_t from, size_t to, size_t& line) {
+        to = std::min(to, n);
+        line += std::count(source.begin() + from, source.begin() + to, '\n');
+        return to;
+    };
+
+    // whether the next token after from is `else`: the statement before it is
+    // the then-branch of a braceless if and must stay in the same chunk
+    auto elseFollows = [&](size_t from) {
+        while (from < n) {
+            if (std::isspace(static_cast<unsigned char>(source[from]))) {
+                ++from;
+            } else if (source.substr(from, 2) == "//") {
+                from = std::min(source.find('\n', from), n);
+            } else if (source.substr(from, 2) == "/*") {
+                const size_t close = source.find("*/", from + 2);
+                from = close == std::string_view::npos ? n : close + 2;
+            } else {
+                break;
+            }
+        }
+        if (source.substr(from, 4) != "else") {
+            return false;
+        }
+        return from + 4 == n || !(std::isalnum(static_cast<unsigned char>(source[from + 4]))
+                                  || source[from + 4] == '_');
+    };
+
+    size_t begin = 0;
+    size_t begin_line = 1;
+    size_t line = 1;
+    size_t depth = 0;
+
+    size_t i = 0;
+    while (i < n) {
+        const char c = source[i];
+
+        if (c == '/' && i + 1 < n && source[i + 1] == '/') {
+            i = skipTo(i, source.find('\n', i), line);
+            continue;
+        }
+        if (c == '/' && i + 1 < n && source[i + 1] == '*') {
+            const size_t close = source.find("*/", i + 2);
+            i = skipTo(i, close == std::string_view::npos ? n : close + 2, line);
+            continue;
+        }
+        if (c == '"' || c == '\'') {
+            const size_t close = source.find(c, i + 1);
+            i = skipTo(i, close == std::string_view::npos ? n : close + 1, line);
+            continue;
+        }
+
+        switch (c) {
+            case '\n':
+                ++line;
+                break;
+            case '{':
+                ++depth;
+                break;
+            case '}':
+                if (depth > 0) {
+                    --depth;
+                }
+                break;
+            case ';':
+                if (depth == 0 && i + 1 - begin >= target && !elseFollows(i + 1)) {
+                    chunks.push_back(Chunk{begin, i + 1, begin_line});
+                    begin = i + 1;
+                    begin_line = line;
+                }
+                break;
+            default:
+                break;
+        }
+        ++i;
+    }
+
+    if (begin < n || chunks.empty()) {
+        chunks.push_back(Chunk{begin, n, begin_line});
+    }
+    return chunks;
+}
+
+namespace {
+
+struct ChunkState {
+    std::unique_ptr<MappedCharStream> input;
+    std::unique_ptr<qasm3Lexer> lexer;
+    std::unique_ptr<antlr4::CommonTokenStream> tokens;
+    std::unique_ptr<qasm3Parser> parser;
+    qasm3Parser::ProgramContext* tree = nullptr;
+    PredictionStage stage = PredictionStage::SLL;
+    bool syntax_errors = false;
+
+    // declared before body: the nodes of body must be destroyed first
+    std::unique_ptr<Arena> arena = std::make_unique<Arena>();
+    Block body;
+    std::unordered_set<size_t> used_gates;
+    std::exception_ptr error;
+
+    // global scope before the first statement of the chunk, with every gate
+    // and subroutine but only the registers and constants declared so far
+    ScopeManager scopes;
+    std::vector<size_t> symbols_after;   // per declaration, global symbol count after it
+};
+
+// runs job(0) .. job(count - 1) on up to jobs threads, including the caller
+template <typename Job>
+void runParallel(size_t count, unsigned jobs, Job job) {
+    std::atomic<size_t> next{0};
+    auto worker = [&] {
+        for (size_t i; (i = next.fetch_add(1)) < count;) {
+            job(i);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    const size_t thread_count = std::min<size_t>(jobs, count);
+    for (size_t t = 1; t < thread_count; ++t) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void rethrowFirstError(const std::vector<ChunkState>& chunks) {
+    for (const auto& chunk : chunks) {
+        if (chunk.error) {
+            std::rethrow_exception(chunk.error);
+        }
+    }
+}
+
+bool isDeclaration(qasm3Parser::StatementOrScopeContext* ctx) {
+    auto* statement = ctx->statement();
+    if (!statement) {
+        return false;
+    }
+    return statement->includeStatement()
+        || statement->gateStatement()
+        || statement->defStatement()
+        || statement->quantumDeclarationStatement()
+        || statement->oldStyleDeclarationStatement()
+        || statement->constDeclarationStatement();
+}
+
+} // namespace
+
+ParallelStats parseParallel(MappedCharStream& input, IR& ir, ScopeManager& scopes, unsigned jobs) {
+    ParallelStats stats;
+
+    auto start = Clock::now();
+    const auto ranges = splitTopLevel(input.contents(), jobs, MIN_CHUNK_SIZE);
+    std::vector<ChunkState> chunks(ranges.size());
+    stats.chunks = chunks.size();
+    stats.split_ms = elapsedMs(start);
+
+    // 1. lex and parse every chunk independently
+    start = Clock::now();
+    runParallel(chunks.size(), jobs, [&](size_t i) {
+        auto& chunk = chunks[i];
+        try {
+            chunk.input = input.slice(ranges[i].begin, ranges[i].end);
+            chunk.lexer = std::make_unique<qasm3Lexer>(chunk.input.get());
+            chunk.lexer->setLine(ranges[i].line);   // diagnostics refer to the whole file
+            chunk.tokens = std::make_unique<antlr4::CommonTokenStream>(chunk.lexer.get());
+            chunk.parser = std::make_unique<qasm3Parser>(chunk.tokens.get());
+
+            // the sequential frontend reports the errors if it comes to that
+            auto parsed = parseTwoStage(*chunk.parser, *chunk.tokens, false);
+            chunk.tree = parsed.tree;
+            chunk.stage = parsed.stage;
+            chunk.syntax_errors = chunk.parser->getNumberOfSyntaxErrors() > 0;
+        } catch (...) {
+            chunk.error = std::current_exception();
+        }
+    });
+    stats.parse_ms = elapsedMs(start);
+    rethrowFirstError(chunks);
+
+    for (const auto& chunk : chunks) {
+        if (!chunk.tree) {
+            throw std::runtime_error("Failed to parse program");
+        }
+        if (chunk.stage == PredictionStage::LL) {
+            ++stats.ll_chunks;
+        }
+    }
+
+    // a cut may still have split a statement the scan does not see through;
+    // the IR is untouched so far, the caller can parse the input as a whole
+    for (const auto& chunk : chunks) {
+        if (chunk.syntax_errors) {
+            stats.syntax_errors = true;
+            return stats;
+        }
+    }
+
+    // 2. declarations in source order, ids match the sequential frontend;
+    //    gates and subroutines may be used before them, as in two-pass mode
+    start = Clock::now();
+    {
+        GateHeadersCollector gate_collector(ir, scopes);
+        for (auto& chunk : chunks) {
+            for (auto* statement : chunk.tree->statementOrScope()) {
+                if (isDeclaration(statement)) {
+                    gate_collector.visit(statement);
+                }
+            }
+        }
+
+        ProgramCollector program_collector(ir, scopes);
+        for (auto& chunk : chunks) {
+            chunk.scopes = scopes;
+            for (auto* statement : chunk.tree->statementOrScope()) {
+                if (isDeclaration(statement)) {
+                    program_collector.visit(statement);
+                    chunk.symbols_after.push_back(scopes.symbolCount());
+                }
+            }
+        }
+    }
+    stats.declarations_ms = elapsedMs(start);
+
+    // 3. lower the rest of each chunk against a read-only IR
+    start = Clock::now();
+    runParallel(chunks.size(), jobs, [&](size_t i) {
+        auto& chunk = chunks[i];
+        try {
+            // registers and constants become visible where they are declared,
+            // so a use before its declaration fails as in the sequential frontend
+            ProgramCollector collector(ir, chunk.scopes, chunk.body, chunk.used_gates, *chunk.arena);
+            size_t declaration = 0;
+            size_t next_symbol = chunk.scopes.symbolCount();
+            for (auto* statement : chunk.tree->statementOrScope()) {
+                if (!isDeclaration(statement)) {
+                    collector.visit(statement);
+                    continue;
+                }
+                for (; next_symbol < chunk.symbols_after[declaration]; ++next_symbol) {
+                    chunk.scopes.addSymbol(scopes.symbol(next_symbol));
+                }
+                ++declaration;
+            }
+        } catch (...) {
+            chunk.error = std::current_exception();
+        }
+    });
+    rethrowFirstError(chunks);
+
+    // 4. merge in chunk order
+    auto& body = ir.getGlobalBlock().body;
+    for (auto& chunk : chunks) {
+        std::move(chunk.body.body.begin(), chunk.body.body.end(), std::back_inserter(body));
+        ir.adoptArena(std::move(chunk.arena));
+        for (auto id : chunk.used_gates) {
+            ir.markGateUsed(id);
+        }
+    }
+    stats.lowering_ms = elapsedMs(start);
+
+    return stats;
+}
+
+} // namespace frontend
+
+/* EOF ParallelFrontend.cpp */
@@ -0,0 +1,271 @@
+/**
+ * @file PassManager.cpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ */
+
+#include "../inc/PassManager.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+namespace passes {
+
+namespace {
+
+void countGates(const std::vector<ProgramNodePtr>& body, std::vector<std::size_t>& counts) {
+    auto count = [&](std::size_t gate_id) {
+        const auto slot = slotIndex(gate_id);
+        if (counts.size() <= slot) {
+            counts.resize(slot + 1, 0);
+        }
+        ++counts[slot];
+    };
+
+    for (const auto& node_ptr : body) {
+        switch (node_ptr->kind) {
+            case NodeKind::Gate:
+                count(static_cast<const GateApplication&>(*node_ptr).gate_id);
+                break;
+            case NodeKind::Loop:
+                countGates(static_cast<const LoopApplication&>(*node_ptr).body.body, counts);
+                break;
+            case NodeKind::Conditional: {
+                const auto& cond = static_cast<const ConditionalApplication&>(*node_ptr);
+                countGates(cond.then_body, counts);
+                countGates(cond.else_body, counts);
+                break;
+            }
+            case NodeKind::Stream:
+                for (auto gate_id : static_cast<const GateStream&>(*node_ptr).gates) {
+                    count(gate_id);
+                }
+                break;
+        }
+    }
+}
+
+struct IRSize {
+    std::size_t gates;
+    std::size_t registers;
+    std::size_t live_qubits;
+};
+
+IRSize sizeOf(const IR& ir, AnalysisCache& analyses) {
+    const auto& liveness = analyses.qubitLiveness();
+    const auto live = static_cast<std::size_t>(std::count(liveness.begin(), liveness.end(), true));
+    return {analyses.gateTotal(), ir.registerCount(), live};
+}
+
+bool usesGate(const IR& ir, const std::string& name) {
+    return ir.hasGate(name) && ir.getGate(name).used;
+}
+
+} // namespace
+
+// ---- AnalysisCache ----
+
+CircuitDag& AnalysisCache::dag() {
+    if (!_dag) {
+        _dag = std::make_unique<CircuitDag>(_ir, _ir.getGlobalBlock());
+    }
+    return *_dag;
+}
+
+const std::vector<bool>& AnalysisCache::qubitLiveness() {
+    if (!_liveness) {
+        const auto& view = dag();
+        _liveness.emplace(view.wireCount());
+        for (CircuitDag::WireId w = 0; w < view.wireCount(); ++w) {
+            (*_liveness)[w] = view.firstOn(w) != CircuitDag::NONE;
+        }
+    }
+    return *_liveness;
+}
+
+const std::vector<std::size_t>& AnalysisCache::gateCounts() {
+    if (!_gate_counts) {
+        _gate_counts.emplace(_ir.getAllGates().slotCount(), 0);
+        countGates(_ir.getGlobalBlock().body, *_gate_counts);
+    }
+    return *_gate_counts;
+}
+
+std::size_t AnalysisCache::gateTotal() {
+    if (!_gate_total) {
+        std::size_t total = 0;
+        for (auto count : gateCounts()) {
+            total += count;
+        }
+        _gate_total = total;
+    }
+    return *_gate_total;
+}
+
+void AnalysisCache::invalidate(Analyses changed) {
+    if (changed & DAG) {
+        _dag.reset();
+    }
+    // liveness is read off the DAG, whose wires change with it
+    if (changed & (DAG | QUBIT_LIVENESS)) {
+        _liveness.reset();
+    }
+    if (changed & GATE_COUNTS) {
+        _gate_counts.reset();
+        _gate_total.reset();
+    }
+}
+
+// ---- PassManager ----
+
+PassManager::PassManager(const PassOptions& options) {
+    registerPass({
+        "unroll",
+        "Unroll loops with constant iteration values, within the unroll budget",
+        [unroll = options.unroll](IR& ir, AnalysisCache&) -> Analyses {
+            const auto stats = unrollLoops(ir, unroll);
+            for (const auto& kept : stats.kept_loops) {
+                std::cerr << "[warning] unroll: kept " << kept << "\n";
+            }
+            return stats.unrolled_loops > 0 ? ALL_ANALYSES : NO_ANALYSES;
+        }
+    });
+    registerPass({
+        "inline",
+        "Inline composite gates, leaving only atomic gates",
+        [](IR& ir, AnalysisCache&) -> Analyses {
+            return inlineCompositeGates(ir) > 0 ? ALL_ANALYSES : NO_ANALYSES;
+        }
+    });
+    registerPass({
+        "decompose-mcx",
+        "Decompose mcx gates into x, cx and ccx gates, adding ancilla qubits",
+        [](IR& ir, AnalysisCache&) -> Analyses {
+            if (!usesGate(ir, "mcx")) {
+                return NO_ANALYSES;
+            }
+            decomposeMCX(ir);
+            return ALL_ANALYSES;
+        }
+    });
+    registerPass({
+        "cancel",
+        "Remove adjacent pairs of mutually inverse gates",
+        [](IR& ir, AnalysisCache& analyses) -> Analyses {
+            // nothing removed: the DAG was not committed and stays valid
+            return cancelInversePairs(ir, analyses.dag()) > 0 ? ALL_ANALYSES : NO_ANALYSES;
+        }
+    });
+    registerPass({
+        "merge-rotations",
+        "Fuse rx, ry and rz rotations of one qubit, dropping zero rotations",
+        [](IR& ir, AnalysisCache& analyses) -> Analyses {
+            return mergeRotations(ir, analyses.dag()) > 0 ? ALL_ANALYSES : NO_ANALYSES;
+        }
+    });
+    registerPass({
+        "merge-registers",
+        "Merge the constant-size qubit registers into one",
+        [](IR& ir, AnalysisCache&) -> Analyses {
+            const auto registers = ir.registerCount();
+            mergeRegisters(ir);
+            // the gates stay, their wires are renumbered
+            return ir.registerCount() == registers ? NO_ANALYSES : DAG | QUBIT_LIVENESS;
+        }
+    });
+    registerPass({
+        "evaluate-angles",
+        "Evaluate gate parameters to double literals",
+        [](IR& ir, AnalysisCache&) -> Analyses {
+            // parameters are edited in place, the DAG reads them from the block
+            evaluateAngles(ir);
+            return NO_ANALYSES;
+        }
+    });
+}
+
+void PassManager::registerPass(Pass pass) {
+    if (hasPass(pass.name)) {
+        throw std::logic_error("Pass already registered: " + pass.name);
+    }
+    _passes.push_back(std::move(pass));
+}
+
+bool PassManager::hasPass(std::string_view name) const {
+    for (const auto& pass : _passes) {
+        if (pass.name == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const Pass& PassManager::find(std::string_view name) const {
+    for (const auto& pass : _passes) {
+        if (pass.name == name) {
+            return pass;
+        }
+    }
+    throw std::invalid_argument("Unknown pass: " + std::string(name));
+}
+
+std::vector<std::string> PassManager::parsePipeline(std::string_view pipeline) const {
+    std::vector<std::string> names;
+    std::size_t start = 0;
+    while (true) {
+        const auto comma = pipeline.find(',', start);
+        const auto name = pipeline.substr(start, comma == std::string_view::npos ? comma : comma - start);
+        if (name.empty()) {
+            throw std::invalid_argument("Empty pass name in pipeline: " + std::string(pipeline));
+        }
+        if (!hasPass(name)) {
+            std::string known;
+            for (const auto& pass : _passes) {
+                known += (known.empty() ? "" : ", ") + pass.name;
+            }
+            throw std::invalid_argument("Unknown pass: " + std::string(name) + " (valid: " + known + ")");
+        }
+        names.emplace_back(name);
+        if (comma == std::string_view::npos) {
+            return names;
+        }
+        start = comma + 1;
+    }
+}
+
+void PassManager::run(IR& ir, const std::vector<std::string>& pipeline, std::ostream* report) const {
+    using Clock = std::chrono::steady_clock;
+    AnalysisCache analyses(ir);
+
+    for (const auto& name : pipeline) {
+        const auto& pass = find(name);
+
+        std::optional<IRSize> before;
+        if (report) {
+            before = sizeOf(ir, analyses);
+        }
+
+        const auto start = Clock::now();
+        Analyses changed;
+        try {
+            changed = pass.run(ir, analyses);
+        } catch (const std::exception& e) {
+            throw std::runtime_error("Error in pass " + pass.name + ": " + e.what());
+        }
+        const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        analyses.invalidate(changed);
+
+        if (report) {
+            const auto after = sizeOf(ir, analyses);
+            *report << "[pass] " << pass.name << ": " << ms << " ms, gates "
+                    << before->gates << " -> " << after.gates << ", registers "
+                    << before->registers << " -> " << after.registers << ", live qubits "
+                    << before->live_qubits << " -> " << after.live_qubits << "\n";
+        }
+    }
+}
+
+} // namespace passes
+
+/* EOF PassManager.cpp */
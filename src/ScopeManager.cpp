@@ -6,6 +6,7 @@
 
 
 #include "ScopeManager.hpp"
+#include <algorithm>
 #include <stdexcept>
 #include <iostream>
 
@@ -14,8 +15,14 @@ ScopeManager::ScopeManager() {
 }
 
 void ScopeManager::enterScope(ScopeKind kind) {
+    const auto index = static_cast<std::uint32_t>(_scopes.size());
     Scope scope;
     scope.kind = kind;
+    scope.first_binding = static_cast<std::uint32_t>(_bindings.size());
+    scope.first_symbol = static_cast<std::uint32_t>(_symbols.size());
+    scope.gate_scope = kind == ScopeKind::GateOrSubroutine ? index
+        : _scopes.empty() ? NONE
+        : _scopes.back().gate_scope;
     _scopes.push_back(scope);
 }
 
@@ -24,62 +31,99 @@ void ScopeManager::exitScope() {
         throw std::logic_error("Exiting scope, but no scope is active");
     }
 
-    if (_scopes.back().kind == ScopeKind::Global) {
+    const auto& scope = _scopes.back();
+    if (scope.kind == ScopeKind::Global) {
         throw std::logic_error("Exiting global scope");
     }
 
+    // undo the bindings of this scope, innermost first
+    while (_bindings.size() > scope.first_binding) {
+        const auto& binding = _bindings.back();
+        _innermost[binding.name] = binding.shadowed;
+        _bindings.pop_back();
+    }
+    _symbols.resize(scope.first_symbol);
+
     _scopes.pop_back();
 }
 
+void ScopeManager::bind(SymbolId name, std::uint32_t symbol) {
+    if (name >= _innermost.size()) {
+        _innermost.resize(name + 1, NONE);
+    }
+    if (_innermost[name] == NONE) {
+        _local_ids.emplace(Interner::global().name(name), name);
+    }
+    const auto scope = static_cast<std::uint32_t>(_scopes.size() - 1);
+    _bindings.push_back(Binding{name, symbol, scope, _innermost[name]});
+    _innermost[name] = static_cast<std::uint32_t>(_bindings.size() - 1);
+}
+
 void ScopeManager::addSymbol(const Symbol& symbol) {
     if (_scopes.empty()) {
         throw std::logic_error("No active scope to define symbol");
     }
 
-    auto& current_scope = _scopes.back();
+    const auto first_binding = _scopes.back().first_binding;
+    auto definedHere = [&](SymbolId name) {
+        return name < _innermost.size() && _innermost[name] != NONE
+            && _innermost[name] >= first_binding;
+    };
 
-    // check canonical name
-    if (current_scope.symbols.count(symbol.name)) {
+    // check canonical name and aliases before binding any of them
+    const SymbolId name_id = symbol.name.id();
+    if (definedHere(name_id)) {
         throw std::runtime_error("Symbol already defined in current scope: " + symbol.name);
     }
-
-    // canonical symbol
-    current_scope.symbols[symbol.name] = symbol;
-
-    // if aliases, add them pointing to the same symbol
+    std::vector<SymbolId> alias_ids;
+    alias_ids.reserve(symbol.aliases.size());
     for (const auto& alias : symbol.aliases) {
-        if (current_scope.symbols.count(alias)) {
+        const SymbolId alias_id = intern(alias);
+        if (definedHere(alias_id) || alias_id == name_id
+            || std::find(alias_ids.begin(), alias_ids.end(), alias_id) != alias_ids.end()) {
             throw std::runtime_error("Alias already defined in current scope: " + alias);
         }
+        alias_ids.push_back(alias_id);
+    }
 
-        Symbol alias_symbol = symbol;
-        alias_symbol.name = alias;
-        current_scope.symbols[alias] = alias_symbol;
+    // aliases are bound to the canonical symbol, not to copies of it
+    const auto index = static_cast<std::uint32_t>(_symbols.size());
+    _symbols.push_back(symbol);
+    bind(name_id, index);
+    for (auto alias_id : alias_ids) {
+        bind(alias_id, index);
     }
 }
 
 
-const Symbol* ScopeManager::lookupSymbol(const std::string& name) const {
-    bool fromGateOrSubroutine = false;
-    for (auto it = _scopes.rbegin(); it != _scopes.rend(); ++it) { // check each scope
-        if (it->kind == ScopeKind::GateOrSubroutine) // in gate def/subroutine
-            fromGateOrSubroutine = true;
+const Symbol* ScopeManager::lookupSymbol(std::string_view name) const {
+    // a name never bound here is not defined; the global interner is not locked
+    auto it = _local_ids.find(name);
+    return it != _local_ids.end() ? lookupSymbol(it->second) : nullptr;
+}
 
-        auto found = it->symbols.find(name);
-        
-        if (found == it->symbols.end()) // not found in current scope
-            continue;
+const Symbol* ScopeManager::lookupSymbol(SymbolId name) const {
+    if (name >= _innermost.size() || _innermost[name] == NONE) {
+        return nullptr;
+    }
 
-        // Found symbol in same or inner scope : always visible
-        if (!fromGateOrSubroutine || it->kind != ScopeKind::Global)
-            return &found->second;
+    // only the innermost binding can be visible, outer ones are shadowed
+    const auto& binding = _bindings[_innermost[name]];
+    const Symbol& sym = _symbols[binding.symbol];
+
+    // Found symbol in same or inner scope as the gate def/subroutine
+    // (or not in one at all) : always visible
+    const auto gate_scope = _scopes.back().gate_scope;
+    if (gate_scope == NONE || binding.scope > gate_scope
+        || _scopes[binding.scope].kind != ScopeKind::Global)
+        return &sym;
+
+    // Found in global, but lookup originates from gate/subroutine
+    // only some symbols are visible from gatedef/subroutine, when in global
+    // scope. refer to https://openqasm.com/language/scope.html#subroutine-and-gate-scope
+    if (isVisibleFromGateOrSubroutineScope(sym))
+        return &sym;
 
-        // Found in global, but lookup originates from gate/subroutine
-        // only some symbols are visible from gatedef/subroutine, when in global
-        // scope. refer to https://openqasm.com/language/scope.html#subroutine-and-gate-scope
-        if (isVisibleFromGateOrSubroutineScope(found->second))
-            return &found->second;
-    }
     return nullptr;
 }
 
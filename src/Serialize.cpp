@@ -0,0 +1,131 @@
+/**
+ * @file Serialize.cpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ */
+
+#include "../inc/Serialize.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace serialize {
+
+template <typename T>
+static void putLittleEndian(std::string& out, T value) {
+    for (std::size_t i = 0; i < sizeof(T); ++i) {
+        out.push_back(static_cast<char>((static_cast<std::uint64_t>(value) >> (8 * i)) & 0xFF));
+    }
+}
+
+template <typename T>
+static T getLittleEndian(const char* in) {
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < sizeof(T); ++i) {
+        value |= static_cast<std::uint64_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    }
+    return static_cast<T>(value);
+}
+
+void Writer::u8(std::uint8_t value) {
+    _bytes.push_back(static_cast<char>(value));
+}
+
+void Writer::u32(std::uint32_t value) {
+    putLittleEndian(_bytes, value);
+}
+
+void Writer::u64(std::uint64_t value) {
+    putLittleEndian(_bytes, value);
+}
+
+void Writer::i64(std::int64_t value) {
+    putLittleEndian(_bytes, static_cast<std::uint64_t>(value));
+}
+
+void Writer::string(std::string_view value) {
+    u32(static_cast<std::uint32_t>(value.size()));
+    _bytes.append(value);
+}
+
+void Writer::strings(const std::vector<std::string>& values) {
+    u32(static_cast<std::uint32_t>(values.size()));
+    for (const auto& value : values) {
+        string(value);
+    }
+}
+
+void Writer::raw(std::string_view bytes) {
+    _bytes.append(bytes);
+}
+
+const char* Reader::take(std::size_t size) {
+    if (size > _bytes.size() - _pos) {
+        throw std::runtime_error("Truncated binary data");
+    }
+    const char* data = _bytes.data() + _pos;
+    _pos += size;
+    return data;
+}
+
+std::uint8_t Reader::u8() {
+    return static_cast<std::uint8_t>(*take(1));
+}
+
+std::uint32_t Reader::u32() {
+    return getLittleEndian<std::uint32_t>(take(4));
+}
+
+std::uint64_t Reader::u64() {
+    return getLittleEndian<std::uint64_t>(take(8));
+}
+
+std::int64_t Reader::i64() {
+    return static_cast<std::int64_t>(getLittleEndian<std::uint64_t>(take(8)));
+}
+
+std::string Reader::string() {
+    const std::uint32_t size = u32();
+    return std::string(take(size), size);
+}
+
+std::vector<std::string> Reader::strings() {
+    const std::uint32_t count = u32();
+    std::vector<std::string> values;
+    values.reserve(std::min<std::size_t>(count, _bytes.size() - _pos));
+    for (std::uint32_t i = 0; i < count; ++i) {
+        values.push_back(string());
+    }
+    return values;
+}
+
+std::string_view Reader::raw(std::size_t size) {
+    return std::string_view(take(size), size);
+}
+
+bool writeFileAtomically(const std::string& path, std::string_view bytes) {
+    const std::string tmp_path = path + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out.good()) {
+            return false;
+        }
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        if (!out.good()) {
+            out.close();
+            std::remove(tmp_path.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace serialize
+
+/* EOF Serialize.cpp */
@@ -0,0 +1,181 @@
+/**
+ * @file StreamingFrontend.cpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ */
+
+#include "../inc/StreamingFrontend.hpp"
+#include "../inc/visitors/GateHeadersCollector.hpp"
+#include "../inc/visitors/ProgramCollector.hpp"
+#include <stdexcept>
+#include <unordered_set>
+
+namespace frontend {
+
+// The parser keeps every context it creates in its tree tracker until it is
+// destroyed or reset, and reset() would also rewind the token stream. This
+// frees the trees only.
+class StatementStream::Parser : public qasm3Parser {
+public:
+    using qasm3Parser::qasm3Parser;
+
+    void releaseTrees() { _tracker.reset(); }
+};
+
+StatementStream::StatementStream(antlr4::TokenSource& source)
+    : _tokens(&source),
+      _parser(std::make_unique<Parser>(&_tokens)),
+      _bail(std::make_shared<antlr4::BailErrorStrategy>()),
+      _recover(std::make_shared<antlr4::DefaultErrorStrategy>()) {
+    _parser->removeErrorListeners();
+    _parser->setErrorHandler(_bail);
+    _parser->getInterpreter<antlr4::atn::ParserATNSimulator>()
+        ->setPredictionMode(antlr4::atn::PredictionMode::SLL);
+}
+
+StatementStream::~StatementStream() {
+    releaseStatement();
+}
+
+void StatementStream::useSLL() {
+    if (!_in_ll) {
+        return;
+    }
+    _parser->removeErrorListeners();
+    _parser->setErrorHandler(_bail);
+    _parser->getInterpreter<antlr4::atn::ParserATNSimulator>()
+        ->setPredictionMode(antlr4::atn::PredictionMode::SLL);
+    _in_ll = false;
+}
+
+void StatementStream::useLL() {
+    _parser->addErrorListener(&antlr4::ConsoleErrorListener::INSTANCE);
+    _recover->reset(_parser.get());
+    _parser->setErrorHandler(_recover);
+    _parser->getInterpreter<antlr4::atn::ParserATNSimulator>()
+        ->setPredictionMode(antlr4::atn::PredictionMode::LL);
+    _in_ll = true;
+}
+
+template <typename Rule>
+auto StatementStream::parseStatement(Rule rule) {
+    const size_t start = _tokens.index();
+
+    useSLL();
+    try {
+        return (_parser.get()->*rule)();
+    } catch (const antlr4::ParseCancellationException&) {
+        // fall through to LL
+    }
+
+    // the statement's tokens are still buffered under the mark
+    _tokens.seek(start);
+    ++_ll_fallbacks;
+    useLL();
+    return (_parser.get()->*rule)();
+}
+
+void StatementStream::releaseStatement() {
+    if (!_marked) {
+        return;
+    }
+    // terminal nodes point into the token buffer, free the trees first
+    _parser->releaseTrees();
+    _tokens.release(_marker);
+    _marked = false;
+}
+
+qasm3Parser::StatementOrScopeContext* StatementStream::next() {
+    releaseStatement();
+
+    if (_at_start) {
+        _at_start = false;
+        if (_tokens.LA(1) == qasm3Parser::OPENQASM) {
+            _marker = _tokens.mark();
+            _marked = true;
+            parseStatement(&qasm3Parser::version);
+            releaseStatement();
+        }
+    }
+
+    if (_tokens.LA(1) == antlr4::Token::EOF) {
+        return nullptr;
+    }
+
+    _marker = _tokens.mark();
+    _marked = true;
+    auto* statement = parseStatement(&qasm3Parser::statementOrScope);
+    ++_statements;
+    return statement;
+}
+
+size_t StatementStream::consumedCharIndex() {
+    return _tokens.LT(1)->getStartIndex();
+}
+
+StreamStats streamProgram(MappedCharStream& input, IR& ir, ScopeManager& scopes,
+                          Printer& printer, std::ostream& out) {
+    if (!printer.supportsStreaming()) {
+        throw std::runtime_error("Target " + printer.name() + " does not support streaming");
+    }
+
+    qasm3Lexer lexer(&input);
+    StatementStream statements(lexer);
+
+    auto& body = ir.getGlobalBlock().body;
+
+    // subroutine bodies stay in the IR's arena; the nodes of every other
+    // statement go to their own arena, freed once they are printed
+    Arena statement_arena;
+    std::unordered_set<size_t> used_gates;
+    GateHeadersCollector gate_collector(ir, scopes);
+    ProgramCollector program_collector(ir, scopes);
+    ProgramCollector statement_collector(ir, scopes, ir.getGlobalBlock(), used_gates, statement_arena);
+
+    size_t announced_registers = 0;
+    StreamStats stats;
+
+    printer.beginStream(out);
+    try {
+        while (auto* statement = statements.next()) {
+            gate_collector.visit(statement);
+            if (statement->statement() && statement->statement()->defStatement()) {
+                program_collector.visit(statement);
+            } else {
+                statement_collector.visit(statement);
+            }
+            for (auto id : used_gates) {
+                ir.markGateUsed(id);
+            }
+            used_gates.clear();
+
+            // nothing is removed while streaming, new registers take the next slots
+            const auto& registers = ir.getAllRegisters();
+            for (; announced_registers < registers.slotCount(); ++announced_registers) {
+                printer.streamRegister(registers[announced_registers], ir, out);
+            }
+
+            for (const auto& node : body) {
+                printer.streamNode(*node, ir, out);
+            }
+            stats.nodes += body.size();
+            body.clear();
+            statement_arena.release();
+
+            input.releaseBefore(statements.consumedCharIndex());
+        }
+    } catch (...) {
+        // the nodes of a failed statement must go before statement_arena does
+        body.clear();
+        throw;
+    }
+    printer.endStream(ir, out);
+
+    stats.statements = statements.statements();
+    stats.ll_fallbacks = statements.llFallbacks();
+    return stats;
+}
+
+} // namespace frontend
+
+/* EOF StreamingFrontend.cpp */
@@ -10,7 +10,7 @@
 static GateApplication makeGateApp(idGate gate_id, std::vector<RegisterRef> operands) {
     GateApplication app;
     app.gate_id  = gate_id;
-    app.operands = std::move(operands);
+    app.operands.assign(operands.begin(), operands.end());
     return app;
 }
 
@@ -0,0 +1,154 @@
+/**
+ * @file inline.cpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ */
+#include "inline.hpp"
+
+#include <cctype>
+#include <stdexcept>
+
+namespace {
+
+bool isIdentifierChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+} // namespace
+
+ParamTemplate ParamTemplate::parse(std::string_view text,
+                                   const std::unordered_map<std::string, std::size_t>& parameter_index) {
+    ParamTemplate result;
+    std::string literal;
+
+    std::size_t i = 0;
+    while (i < text.size()) {
+        const bool starts_word = (std::isalpha(static_cast<unsigned char>(text[i])) || text[i] == '_')
+            && (i == 0 || !isIdentifierChar(text[i - 1]));
+        if (!starts_word) {
+            literal += text[i++];
+            continue;
+        }
+        auto end = i;
+        while (end < text.size() && isIdentifierChar(text[end])) {
+            ++end;
+        }
+        const auto word = text.substr(i, end - i);
+        i = end;
+
+        auto it = parameter_index.find(std::string(word));
+        if (it == parameter_index.end()) {
+            literal += word;
+            continue;
+        }
+        if (!literal.empty()) {
+            result.pieces.push_back({std::move(literal)});
+            literal.clear();
+        }
+        result.pieces.push_back({"", it->second});
+    }
+    if (!literal.empty() || result.pieces.empty()) {
+        result.pieces.push_back({std::move(literal)});
+    }
+    return result;
+}
+
+const std::vector<FlatGate>& CompositeTemplates::flatten(const IR& ir, idGate id) {
+    // sized once, entries of nested gates are referred to while building
+    if (_entries.size() < ir.getAllGates().slotCount()) {
+        _entries.resize(ir.getAllGates().slotCount());
+    }
+
+    const auto slot = slotIndex(id);
+    if (_entries[slot].built) {
+        return _entries[slot].gates;
+    }
+
+    const auto& gate = ir.getGate(id);
+    const auto* body = std::get_if<CompositeGateBody>(&gate.semantics);
+    if (!body) {
+        throw std::logic_error("Not a composite gate: " + gate.name);
+    }
+    if (_entries[slot].building) {
+        throw std::runtime_error("Gate " + gate.name + " contains itself");
+    }
+
+    _entries[slot].building = true;
+    std::vector<FlatGate> gates;
+    try {
+        flattenBody(ir, gate, body->body, gates);
+    } catch (...) {
+        _entries[slot].building = false;
+        throw;
+    }
+    _entries[slot].gates = std::move(gates);
+    _entries[slot].building = false;
+    _entries[slot].built = true;
+    return _entries[slot].gates;
+}
+
+void CompositeTemplates::flattenBody(const IR& ir, const GateDef& gate, const std::vector<GateStmt>& body,
+                                     std::vector<FlatGate>& out) {
+    for (const auto& stmt : body) {
+        if (const auto* repeat = std::get_if<RepeatBlock>(&stmt)) {
+            std::vector<FlatGate> once;
+            flattenBody(ir, gate, repeat->body, once);
+            out.reserve(out.size() + once.size() * repeat->count);
+            for (std::size_t k = 0; k < repeat->count; ++k) {
+                out.insert(out.end(), once.begin(), once.end());
+            }
+            continue;
+        }
+
+        const auto& placement = std::get<GatePlacement>(stmt);
+        const auto& callee = ir.getGate(placement.gate_id);
+        if (placement.relativeInputs.size() < callee.argument_qubits.size()
+            || placement.params.size() < callee.parameters.size()) {
+            throw std::runtime_error("Call of " + callee.name + " in gate " + gate.name
+                                     + " has too few qubits or parameters");
+        }
+
+        if (callee.kind == GateKind::Atomic) {
+            FlatGate flat{placement.gate_id, placement.relativeInputs, {}};
+            flat.params.reserve(placement.params.size());
+            for (const auto& param : placement.params) {
+                flat.params.push_back(ParamTemplate::parse(param, gate.parameter_index));
+            }
+            out.push_back(std::move(flat));
+            continue;
+        }
+
+        // the callee's flat gates, remapped onto this gate's arguments and parameters
+        for (const auto& inner : flatten(ir, placement.gate_id)) {
+            FlatGate flat{inner.gate_id, {}, {}};
+            flat.inputs.reserve(inner.inputs.size());
+            for (auto input : inner.inputs) {
+                flat.inputs.push_back(placement.relativeInputs[input]);
+            }
+            flat.params.reserve(inner.params.size());
+            for (const auto& param : inner.params) {
+                flat.params.push_back(ParamTemplate::parse(param.instantiate(placement.params),
+                                                           gate.parameter_index));
+            }
+            out.push_back(std::move(flat));
+        }
+    }
+}
+
+void CompositeTemplates::instantiate(const FlatGate& flat, const GateApplication& call, GateApplication& out) {
+    out.gate_id = flat.gate_id;
+    out.operands.clear();
+    for (auto input : flat.inputs) {
+        out.operands.push_back(call.operands[input]);
+    }
+    out.params.clear();
+    for (const auto& param : flat.params) {
+        out.params.emplace_back(param.instantiate(call.params));
+    }
+}
+
+void CompositeTemplates::clear() {
+    _entries.clear();
+}
+
+/* EOF inline.cpp */
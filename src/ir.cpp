@@ -7,26 +7,101 @@
 #include "ir.hpp"
 #include <stdexcept>
 #include <iostream>
+#include <charconv>
+#include <cctype>
+#include <cstdint>
+
+void NodeDeleter::operator()(ProgramNodeBase* node) const {
+    if (!node) {
+        return;
+    }
+    // the memory belongs to the arena
+    switch (node->kind) {
+        case NodeKind::Gate:
+            static_cast<GateApplication*>(node)->~GateApplication();
+            break;
+        case NodeKind::Loop:
+            static_cast<LoopApplication*>(node)->~LoopApplication();
+            break;
+        case NodeKind::Conditional:
+            static_cast<ConditionalApplication*>(node)->~ConditionalApplication();
+            break;
+        case NodeKind::Stream:
+            static_cast<GateStream*>(node)->~GateStream();
+            break;
+    }
+}
+
+bool GateStream::accepts(const GateApplication& app) {
+    if (app.gate_id > UINT32_MAX) {
+        return false;
+    }
+    for (const auto& op : app.operands) {
+        if (!op.index.isLiteral() || op.reg_id > UINT32_MAX
+            || op.index.offset < INT32_MIN || op.index.offset > INT32_MAX) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void GateStream::append(const GateApplication& app) {
+    gates.push_back(static_cast<std::uint32_t>(app.gate_id));
+    for (const auto& op : app.operands) {
+        operand_regs.push_back(static_cast<std::uint32_t>(op.reg_id));
+        operand_indices.push_back(static_cast<std::int32_t>(op.index.offset));
+    }
+    operand_offsets.push_back(static_cast<std::uint32_t>(operand_regs.size()));
+    params.insert(params.end(), app.params.begin(), app.params.end());
+    param_offsets.push_back(static_cast<std::uint32_t>(params.size()));
+}
+
+void GateStream::append(const GateStream& other, std::size_t i) {
+    gates.push_back(other.gates[i]);
+    for (auto j = other.operand_offsets[i]; j < other.operand_offsets[i + 1]; ++j) {
+        operand_regs.push_back(other.operand_regs[j]);
+        operand_indices.push_back(other.operand_indices[j]);
+    }
+    operand_offsets.push_back(static_cast<std::uint32_t>(operand_regs.size()));
+    params.insert(params.end(), other.params.begin() + other.param_offsets[i],
+                  other.params.begin() + other.param_offsets[i + 1]);
+    param_offsets.push_back(static_cast<std::uint32_t>(params.size()));
+}
+
+GateApplication GateStream::unpack(std::size_t i) const {
+    GateApplication app;
+    app.gate_id = gates[i];
+    for (auto j = operand_offsets[i]; j < operand_offsets[i + 1]; ++j) {
+        app.operands.push_back(RegisterRef{operand_regs[j], IndexExpr::literal(operand_indices[j])});
+    }
+    app.params.assign(params.begin() + param_offsets[i], params.begin() + param_offsets[i + 1]);
+    return app;
+}
+
+IR::NameTable::const_iterator IR::findName(const NameTable& table, const std::string& name) {
+    // a name nobody interned cannot be in any table
+    auto id = Interner::global().find(name);
+    return id ? table.find(*id) : table.end();
+}
 
 std::size_t IR::addRegister(const RegisterDef& def) {
     if (hasRegister(def.name)) {
         throw std::runtime_error("Register already exists: " + def.name);
     }
-    std::size_t id = registers.size();
-    registers.push_back(def);
-    register_table[def.name] = id;
+    std::size_t id = registers.insert(def);
+    register_table[def.name.id()] = id;
     return id;
 }
 
 const RegisterDef& IR::getRegister(std::size_t id) const {
-    if (id >= registers.size()) {
+    if (!registers.contains(id)) {
         throw std::out_of_range("Invalid register id");
     }
     return registers[id];
 }
 
 const RegisterDef& IR::getRegister(const std::string& name) const {
-    auto it = register_table.find(name);
+    auto it = findName(register_table, name);
     if (it == register_table.end()) {
         throw std::runtime_error("Unknown register: " + name);
     }
@@ -34,24 +109,50 @@ const RegisterDef& IR::getRegister(const std::string& name) const {
 }
 
 RegisterDef& IR::getRegister(std::size_t id) {
+    if (!registers.contains(id)) {
+        throw std::out_of_range("Invalid register id");
+    }
     return registers[id];
 }
 
 RegisterDef& IR::getRegister(const std::string& name) {
-    return registers[register_table.at(name)];
+    auto it = findName(register_table, name);
+    if (it == register_table.end()) {
+        throw std::runtime_error("Unknown register: " + name);
+    }
+    return registers[it->second];
 }
 
 void IR::removeRegister(std::size_t id) {
-    if (id >= registers.size()) {
+    if (!registers.contains(id)) {
+        throw std::out_of_range("Invalid register id");
+    }
+    register_table.erase(registers[id].name.id());
+    registers.erase(id);
+}
+
+void IR::addRegisterAt(std::size_t id, const RegisterDef& def) {
+    if (hasRegister(def.name)) {
+        throw std::runtime_error("Register already exists: " + def.name);
+    }
+    registers.insertAt(id, def);
+    register_table[def.name.id()] = id;
+}
+
+void IR::renameRegister(std::size_t id, const std::string& name) {
+    if (!registers.contains(id)) {
         throw std::out_of_range("Invalid register id");
     }
-    const std::string name = registers[id].name;
-    register_table.erase(name);
-    registers.erase(registers.begin() + id);
+    if (hasRegister(name)) {
+        throw std::runtime_error("Register already exists: " + name);
+    }
+    register_table.erase(registers[id].name.id());
+    registers[id].name = name;
+    register_table[intern(name)] = id;
 }
 
 const idRegister IR::getRegisterId(std::string name) const {
-    auto it = register_table.find(name);
+    auto it = findName(register_table, name);
     if (it == register_table.end()) {
         throw std::runtime_error("Register not found: " + name);
     }
@@ -59,64 +160,92 @@ const idRegister IR::getRegisterId(std::string name) const {
 }
 
 
-const std::vector<RegisterDef> IR::getAllRegisters() const {
+const SlotMap<RegisterDef>& IR::getAllRegisters() const {
     return this->registers;
 }
 
+std::size_t IR::registerCount() const {
+    return this->registers.size();
+}
+
 bool IR::hasRegister(const std::string& name) const {
-    return register_table.find(name) != register_table.end();
+    return findName(register_table, name) != register_table.end();
 }
 
-std::size_t IR::addGate(const GateDef& def) {
+void IR::checkGateNames(const GateDef& def) const {
     if (hasGate(def.name)) {
         throw std::runtime_error("Gate already exists: " + def.name);
     }
+    for (const auto& alias : def.aliases) {
+        if (hasGate(alias)) {
+            throw std::runtime_error("Alias already exists: " + alias);
+        }
+    }
+}
 
-    std::size_t id = gates.size();
-    gates.push_back(def);
-
+void IR::bindGateNames(const GateDef& def, std::size_t id) {
     // register canonical name
-    gate_table[def.name] = id;
+    gate_table[def.name.id()] = id;
 
     // register aliases
     for (const auto& alias : def.aliases) {
-        if (hasGate(alias)) {
-            throw std::runtime_error("Alias already exists: " + alias);
-        }
-        gate_table[alias] = id;
+        gate_table[intern(alias)] = id;
     }
+}
 
+std::size_t IR::addGate(const GateDef& def) {
+    checkGateNames(def);
+    std::size_t id = gates.insert(def);
+    bindGateNames(def, id);
     return id;
 }
 
+void IR::addGateAt(std::size_t id, const GateDef& def) {
+    checkGateNames(def);
+    gates.insertAt(id, def);
+    bindGateNames(def, id);
+}
+
 
 const GateDef& IR::getGate(std::size_t id) const {
-    if (id >= gates.size()) {
+    if (!gates.contains(id)) {
         throw std::out_of_range("Invalid gate id");
     }
     return gates[id];
 }
 
 const GateDef& IR::getGate(const std::string& name) const {
-    auto it = gate_table.find(name);
+    auto it = findName(gate_table, name);
     if (it == gate_table.end()) {
         throw std::runtime_error("Unknown gate: " + name);
     }
     return gates[it->second];
 }
 
-GateDef& IR::getGate(std::size_t id) { return gates.at(id); }
-GateDef& IR::getGate(const std::string& name) { return gates.at(gate_table.at(name)); }
+GateDef& IR::getGate(std::size_t id) {
+    if (!gates.contains(id)) {
+        throw std::out_of_range("Invalid gate id");
+    }
+    return gates[id];
+}
+
+GateDef& IR::getGate(const std::string& name) {
+    auto it = findName(gate_table, name);
+    if (it == gate_table.end()) {
+        throw std::runtime_error("Unknown gate: " + name);
+    }
+    return gates[it->second];
+}
 
 void IR::markGateUsed(std::size_t id) {
-    if (id >= gates.size()) {
+    if (!gates.contains(id)) {
         throw std::out_of_range("Invalid gate id");
     }
     gates[id].used = true;
 }
 
 void IR::markGateUsed(const std::string& name) {
-    auto it = gate_table.find(name);
+    auto it = findName(gate_table, name);
     if (it == gate_table.end()) {
         throw std::runtime_error("Unknown gate: " + name);
     }
@@ -124,27 +253,43 @@ void IR::markGateUsed(const std::string& name) {
 }
 
 void IR::markGateUnused(std::size_t id) {
-    if (id >= gates.size()) {
+    if (!gates.contains(id)) {
         throw std::out_of_range("Invalid gate id");
     }
     gates[id].used = false;
 }
 
 void IR::markGateUnused(const std::string& name) {
-    auto it = gate_table.find(name);
+    auto it = findName(gate_table, name);
     if (it == gate_table.end()) {
         throw std::runtime_error("Unknown gate: " + name);
     }
     gates[it->second].used = false;
 }
 
+void IR::removeGate(std::size_t id) {
+    if (!gates.contains(id)) {
+        throw std::out_of_range("Invalid gate id");
+    }
+    const auto& gate = gates[id];
+    gate_table.erase(gate.name.id());
+    for (const auto& alias : gate.aliases) {
+        gate_table.erase(intern(alias));
+    }
+    gates.erase(id);
+}
+
 
-const std::vector<GateDef> IR::getAllGates() const {
+const SlotMap<GateDef>& IR::getAllGates() const {
     return this->gates;
 }
 
+std::size_t IR::gateCount() const {
+    return this->gates.size();
+}
+
 const idGate IR::getGateId(std::string name) const {
-    auto it = gate_table.find(name);
+    auto it = findName(gate_table, name);
     if (it == gate_table.end()) {
         throw std::runtime_error("Gate not found: " + name);
     }
@@ -152,7 +297,34 @@ const idGate IR::getGateId(std::string name) const {
 }
 
 bool IR::hasGate(const std::string& name) const {
-    return gate_table.find(name) != gate_table.end();
+    return findName(gate_table, name) != gate_table.end();
+}
+
+IR& IR::operator=(IR&& other) noexcept {
+    if (this == &other) {
+        return *this;
+    }
+    // memberwise assignment would replace the arenas first and then free
+    // nodes (and their pmr vectors) into released memory
+    global_block = Block();
+    subroutines = SlotMap<SubroutineDef>();
+
+    node_arena = std::move(other.node_arena);
+    adopted_arenas = std::move(other.adopted_arenas);
+    registers = std::move(other.registers);
+    gates = std::move(other.gates);
+    subroutines = std::move(other.subroutines);
+    global_block = std::move(other.global_block);
+    register_table = std::move(other.register_table);
+    gate_table = std::move(other.gate_table);
+    subroutine_table = std::move(other.subroutine_table);
+    return *this;
+}
+
+Arena& IR::arena() { return *node_arena; }
+
+void IR::adoptArena(std::unique_ptr<Arena> arena) {
+    adopted_arenas.push_back(std::move(arena));
 }
 
 Block& IR::getGlobalBlock() { return global_block; }
@@ -167,27 +339,45 @@ const VariableDef& IR::getGlobalVariable(const std::string& name) const {
     throw std::runtime_error("Global variable not found: " + name);
 }
 
+std::optional<std::ptrdiff_t> IR::getConstantValue(std::string_view name) const {
+    for (const auto& var : global_block.variables) {
+        if (var.is_const && var.name == name && !var.compile_time_value.empty()) {
+            return std::stoll(var.compile_time_value);
+        }
+    }
+    return std::nullopt;
+}
+
 std::size_t IR::addSubroutine(SubroutineDef&& def) {
     if (hasSubroutine(def.name)) {
         throw std::runtime_error("Subroutine already exists: " + def.name);
     }
 
-    std::size_t id = subroutines.size();
-    subroutine_table[def.name] = id;
-    subroutines.push_back(std::move(def));
+    const SymbolId name = def.name.id();
+    std::size_t id = subroutines.insert(std::move(def));
+    subroutine_table[name] = id;
 
     return id;
 }
 
+void IR::addSubroutineAt(std::size_t id, SubroutineDef&& def) {
+    if (hasSubroutine(def.name)) {
+        throw std::runtime_error("Subroutine already exists: " + def.name);
+    }
+    const SymbolId name = def.name.id();
+    subroutines.insertAt(id, std::move(def));
+    subroutine_table[name] = id;
+}
+
 const SubroutineDef& IR::getSubroutine(std::size_t id) const {
-    if (id >= subroutines.size()) {
+    if (!subroutines.contains(id)) {
         throw std::out_of_range("Invalid subroutine id");
     }
     return subroutines[id];
 }
 
 const SubroutineDef& IR::getSubroutine(const std::string& name) const {
-    auto it = subroutine_table.find(name);
+    auto it = findName(subroutine_table, name);
     if (it == subroutine_table.end()) {
         throw std::runtime_error("Unknown subroutine: " + name);
     }
@@ -195,26 +385,26 @@ const SubroutineDef& IR::getSubroutine(const std::string& name) const {
 }
 
 SubroutineDef& IR::getSubroutine(const std::string& name) {
-    auto it = subroutine_table.find(name);
+    auto it = findName(subroutine_table, name);
     if (it == subroutine_table.end()) {
         throw std::runtime_error("Unknown subroutine: " + name);
     }
-    return subroutines.at(it->second);
+    return subroutines[it->second];
 }
 
 SubroutineDef& IR::getSubroutine(std::size_t id) {
-    if (id >= subroutines.size()) {
+    if (!subroutines.contains(id)) {
         throw std::out_of_range("Invalid subroutine id");
     }
     return subroutines[id];
 }
 
-const std::vector<SubroutineDef>& IR::getAllSubroutines() const {
+const SlotMap<SubroutineDef>& IR::getAllSubroutines() const {
     return subroutines;
 }
 
 const idGate IR::getSubroutineId(std::string name) const {
-    auto it = subroutine_table.find(name);
+    auto it = findName(subroutine_table, name);
     if (it == subroutine_table.end()) {
         throw std::runtime_error("Subroutine not found: " + name);
     }
@@ -222,24 +412,32 @@ const idGate IR::getSubroutineId(std::string name) const {
 }
 
 bool IR::hasSubroutine(const std::string& name) const {
-    return subroutine_table.find(name) != subroutine_table.end();
+    return findName(subroutine_table, name) != subroutine_table.end();
 }
 
 void IR::markSubroutineUsed(std::size_t id) {
-    if (id >= subroutines.size()) {
+    if (!subroutines.contains(id)) {
         throw std::out_of_range("Invalid subroutine id");
     }
     subroutines[id].used = true;
 }
 
 void IR::markSubroutineUsed(const std::string& name) {
-    auto it = subroutine_table.find(name);
+    auto it = findName(subroutine_table, name);
     if (it == subroutine_table.end()) {
         throw std::runtime_error("Unknown subroutine: " + name);
     }
     subroutines[it->second].used = true;
 }
 
+void IR::removeSubroutine(std::size_t id) {
+    if (!subroutines.contains(id)) {
+        throw std::out_of_range("Invalid subroutine id");
+    }
+    subroutine_table.erase(subroutines[id].name.id());
+    subroutines.erase(id);
+}
+
 int IR::resolveLoopCount(const LoopValues& values) const {
     if (std::holds_alternative<Interval>(values)) {
         const auto& interval = std::get<Interval>(values);
@@ -261,4 +459,249 @@ int IR::resolveLoopCount(const LoopValues& values) const {
     }
 }
 
+IndexExpr IndexExpr::literal(std::ptrdiff_t value) {
+    IndexExpr index;
+    index.offset = value;
+    return index;
+}
+
+void IndexExpr::shift(std::ptrdiff_t by) {
+    if (isAffine()) {
+        offset += by;
+    } else {
+        opaque = "(" + opaque + ")+" + std::to_string(by);
+    }
+}
+
+std::string IndexExpr::str() const {
+    if (!isAffine()) {
+        return opaque;
+    }
+    if (!symbol) {
+        return std::to_string(offset);
+    }
+
+    std::string text;
+    if (scale == -1) {
+        text = "-";
+    } else if (scale != 1) {
+        text = std::to_string(scale) + "*";
+    }
+    text += symbolName(*symbol);
+    if (offset > 0) {
+        text += "+" + std::to_string(offset);
+    } else if (offset < 0) {
+        text += std::to_string(offset);
+    }
+    return text;
+}
+
+namespace {
+
+// recursive descent over + - * ( ), folding into scale * symbol + offset
+class IndexParser {
+public:
+    IndexParser(std::string_view text,
+                const std::function<std::optional<std::ptrdiff_t>(std::string_view)>& constant)
+        : _text(text), _constant(constant) {}
+
+    std::optional<IndexExpr> parse() {
+        auto index = sum();
+        skipSpaces();
+        if (!index || _pos != _text.size()) {
+            return std::nullopt;
+        }
+        return index;
+    }
+
+private:
+    std::string_view _text;
+    const std::function<std::optional<std::ptrdiff_t>(std::string_view)>& _constant;
+    size_t _pos = 0;
+
+    void skipSpaces() {
+        while (_pos < _text.size() && std::isspace(static_cast<unsigned char>(_text[_pos]))) {
+            ++_pos;
+        }
+    }
+
+    bool accept(char c) {
+        skipSpaces();
+        if (_pos < _text.size() && _text[_pos] == c) {
+            ++_pos;
+            return true;
+        }
+        return false;
+    }
+
+    static std::optional<IndexExpr> add(const IndexExpr& a, const IndexExpr& b, std::ptrdiff_t sign) {
+        if (a.symbol && b.symbol && *a.symbol != *b.symbol) {
+            return std::nullopt;    // two variables
+        }
+        IndexExpr result;
+        result.symbol = a.symbol ? a.symbol : b.symbol;
+        std::ptrdiff_t scale, offset;
+        if (__builtin_mul_overflow(sign, b.scale, &scale)
+            || __builtin_mul_overflow(sign, b.offset, &offset)
+            || __builtin_add_overflow(a.scale, scale, &result.scale)
+            || __builtin_add_overflow(a.offset, offset, &result.offset)) {
+            return std::nullopt;    // out of range, kept as opaque text
+        }
+        if (result.scale == 0) {
+            result.symbol.reset();
+        }
+        return result;
+    }
+
+    static std::optional<IndexExpr> multiply(const IndexExpr& a, const IndexExpr& b) {
+        if (a.symbol && b.symbol) {
+            return std::nullopt;    // quadratic
+        }
+        const IndexExpr& factor = a.symbol ? b : a;
+        const IndexExpr& term = a.symbol ? a : b;
+        IndexExpr result;
+        result.symbol = term.symbol;
+        if (__builtin_mul_overflow(term.scale, factor.offset, &result.scale)
+            || __builtin_mul_overflow(term.offset, factor.offset, &result.offset)) {
+            return std::nullopt;    // out of range, kept as opaque text
+        }
+        if (result.scale == 0) {
+            result.symbol.reset();
+        }
+        return result;
+    }
+
+    std::optional<IndexExpr> sum() {
+        auto result = product();
+        while (result) {
+            std::ptrdiff_t sign;
+            if (accept('+')) {
+                sign = 1;
+            } else if (accept('-')) {
+                sign = -1;
+            } else {
+                break;
+            }
+            auto rhs = product();
+            if (!rhs) {
+                return std::nullopt;
+            }
+            result = add(*result, *rhs, sign);
+        }
+        return result;
+    }
+
+    std::optional<IndexExpr> product() {
+        auto result = unary();
+        while (result && accept('*')) {
+            auto rhs = unary();
+            if (!rhs) {
+                return std::nullopt;
+            }
+            result = multiply(*result, *rhs);
+        }
+        return result;
+    }
+
+    std::optional<IndexExpr> unary() {
+        if (accept('-')) {
+            auto operand = unary();
+            if (!operand) {
+                return std::nullopt;
+            }
+            return multiply(IndexExpr::literal(-1), *operand);
+        }
+        if (accept('+')) {
+            return unary();
+        }
+        return primary();
+    }
+
+    std::optional<IndexExpr> primary() {
+        if (accept('(')) {
+            auto inner = sum();
+            if (!inner || !accept(')')) {
+                return std::nullopt;
+            }
+            return inner;
+        }
+
+        skipSpaces();
+        const size_t start = _pos;
+        if (_pos < _text.size() && std::isdigit(static_cast<unsigned char>(_text[_pos]))) {
+            while (_pos < _text.size() && std::isdigit(static_cast<unsigned char>(_text[_pos]))) {
+                ++_pos;
+            }
+            std::ptrdiff_t value;
+            auto [ptr, ec] = std::from_chars(_text.data() + start, _text.data() + _pos, value);
+            if (ec != std::errc()) {
+                return std::nullopt;   // out of range, kept as opaque text
+            }
+            return IndexExpr::literal(value);
+        }
+        while (_pos < _text.size()
+               && (std::isalnum(static_cast<unsigned char>(_text[_pos])) || _text[_pos] == '_')) {
+            ++_pos;
+        }
+        if (_pos == start) {
+            return std::nullopt;
+        }
+
+        const auto name = _text.substr(start, _pos - start);
+        if (_constant) {
+            if (auto value = _constant(name)) {
+                return IndexExpr::literal(*value);
+            }
+        }
+        IndexExpr index;
+        index.scale = 1;
+        index.symbol = intern(name);
+        return index;
+    }
+};
+
+} // namespace
+
+IndexExpr parseIndexExpr(std::string_view text,
+    const std::function<std::optional<std::ptrdiff_t>(std::string_view)>& constant) {
+    if (auto index = IndexParser(text, constant).parse()) {
+        return *index;
+    }
+    IndexExpr index;
+    index.opaque = std::string(text);
+    return index;
+}
+
+QubitLayout::QubitLayout(const IR& ir) {
+    _base.reserve(ir.getAllRegisters().slotCount());
+    const auto qubit_registers = ir.qubitRegisters();
+    for (auto it = qubit_registers.begin(); it != qubit_registers.end(); ++it) {
+        add(it.id(), *it);
+    }
+}
+
+void QubitLayout::add(idRegister id, const RegisterDef& reg) {
+    if (reg.type != RegisterType::Qubit) {
+        return;
+    }
+    const auto slot = slotIndex(id);
+    if (_base.size() <= slot) {
+        _base.resize(slot + 1, NONE);
+    }
+    _base[slot] = _qubit_count;
+    _qubit_count += std::stoul(reg.size);  // compile time constant
+}
+
+bool QubitLayout::contains(idRegister id) const {
+    const auto slot = slotIndex(id);
+    return slot < _base.size() && _base[slot] != NONE;
+}
+
+std::size_t QubitLayout::base(idRegister id) const {
+    if (!contains(id)) {
+        throw std::out_of_range("Register " + std::to_string(id) + " has no qubits in the layout");
+    }
+    return _base[slotIndex(id)];
+}
+
 /* EOF ir.cpp */
\ No newline at end of file
@@ -1,13 +1,26 @@
 // main.cpp
+#include <chrono>
 #include <cstdio>
+#include <filesystem>
 #include <iostream>
 #include <fstream>
 #include <memory>
+#include <optional>
+#include <sstream>
 #include <antlr4-runtime/antlr4-runtime.h>
 #include "../antlr/parser/qasm3Lexer.h"
 #include "../antlr/parser/qasm3Parser.h"
 #include "../antlr/parser/qasm3ParserBaseVisitor.h"
 #include "../inc/ir.hpp"
+#include "../inc/MappedCharStream.hpp"
+#include "../inc/Frontend.hpp"
+#include "../inc/FastPathParser.hpp"
+#include "../inc/StreamingFrontend.hpp"
+#include "../inc/ParallelFrontend.hpp"
+#include "../inc/MemoryUsage.hpp"
+#include "../inc/GateLibrary.hpp"
+#include "../inc/IRSnapshot.hpp"
+#include "../inc/OutputCache.hpp"
 #include "../inc/visitors/GateHeadersCollector.hpp"
 #include "../inc/visitors/ProgramCollector.hpp"
 #include "../inc/AtomicGateLoader.hpp"
@@ -18,10 +31,17 @@
 #include "../inc/printers/OpenQASMPrinter.hpp"
 #include "../inc/ArgParser.hpp"
 #include "../inc/Passes.hpp"
+#include "../inc/PassManager.hpp"
 #include "../inc/printers/StatsPrinter.hpp"
 #include "../inc/printers/MOSFPrinter.hpp"
 
 using namespace antlr4;
+using frontend::Clock;
+using frontend::elapsedMs;
+
+static void reportTiming(const std::string& phase, double ms) {
+    std::cerr << "[timing] " << phase << ": " << ms << " ms\n";
+}
 
 
 std::unique_ptr<Printer> selectPrinter(const std::string& target, 
@@ -53,101 +73,358 @@ std::unique_ptr<Printer> selectPrinter(const std::string& target,
 }
 
 
-int main(int argc, const char* argv[]) {
-    ArgParser::Args args;
-    try {
-        args = ArgParser::parse(argc, argv);
-    } catch (const std::exception& e) {
-        std::cerr << e.what() << "\n";
-        ArgParser::printUsage(argv[0]);
-        return 1;
-    }
-
-    std::istream* input_ptr = &std::cin;
-    std::ifstream input_file_stream;
+static void reportMemory(const std::string& phase) {
+    auto usage = memory::current();
+    std::cerr << "[memory] " << phase << ": peak " << usage.peak_kb / 1024.0
+              << " MiB, now " << usage.rss_kb / 1024.0 << " MiB\n";
+    // the next report covers only the phase in between
+    memory::resetPeak();
+}
 
-    if (!args.input_file.empty()) {
-        input_file_stream.open(args.input_file);
-        if (!input_file_stream.good()) {
-            std::cerr << "Error: Could not open file: " << args.input_file << "\n";
-            return 1;
+static bool loadBuiltinGates(IR& ir, ScopeManager& scopes) {
+    try {
+        // loaded once per process, batch runs share it
+        static const std::vector<GateDef> gates =
+            gate_library::loadGateTable("json_gates/gates.json");
+        for (const auto& gate : gates) {
+            auto id = ir.addGate(gate);
+            Symbol sym;
+            sym.name = gate.name;
+            sym.aliases = gate.aliases;
+            sym.ir_ref = id;
+            sym.kind = SymbolKind::Gate;
+            scopes.addSymbol(std::move(sym));
         }
-        input_ptr = &input_file_stream;
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading gates: " << e.what() << "\n";
+        return false;
     }
+    return true;
+}
 
-    ANTLRInputStream input(*input_ptr);
+static bool buildIRWithAntlr(MappedCharStream& input, IR& ir, ScopeManager& scopes,
+                             const ArgParser::Args& args) {
     qasm3Lexer lexer(&input);
     CommonTokenStream tokens(&lexer);
     qasm3Parser parser(&tokens);
 
     tree::ParseTree* tree = nullptr;
     try {
-        tree = parser.program();
+        auto parsed = frontend::parseTwoStage(parser, tokens);
+        tree = parsed.tree;
         if (!tree) {
             std::cerr << "Error: Failed to parse program\n";
-            return 1;
+            return false;
         }
-    } catch (const std::exception& e) {
-        std::cerr << "Error during ANTLR parsing: " << e.what() << "\n";
-        return 1;
-    }
-
-    IR ir;
-    ScopeManager scopes;
 
-    try {
-        auto gates = loadGates("json_gates/gates.json", args.use_algebraic, args.algebraic_precision);
-        for (const auto& gate : gates) {
-            auto id = ir.addGate(gate);
-            Symbol sym;
-            sym.name = gate.name;
-            sym.aliases = gate.aliases;
-            sym.ir_ref = id;
-            sym.kind = SymbolKind::Gate;
-            scopes.addSymbol(std::move(sym));
+        if (args.report_timing) {
+            reportTiming("lexing", parsed.lex_ms);
+            reportTiming("parsing (SLL)", parsed.sll_ms);
+            if (parsed.stage == frontend::PredictionStage::LL) {
+                reportTiming("parsing (LL fallback)", parsed.ll_ms);
+            }
+            std::cerr << "[timing] prediction mode used: "
+                      << frontend::toString(parsed.stage) << "\n";
         }
     } catch (const std::exception& e) {
-        std::cerr << "Error loading gates: " << e.what() << "\n";
-        return 1;
+        std::cerr << "Error during ANTLR parsing: " << e.what() << "\n";
+        return false;
     }
 
     // Visitor passes
+    auto phase_start = Clock::now();
     try {
-        GateHeadersCollector gate_collector(ir, scopes);
-        gate_collector.visit(tree);
+        if (args.two_pass) {
+            GateHeadersCollector gate_collector(ir, scopes);
+            gate_collector.visit(tree);
 
-        ProgramCollector program_collector(ir, scopes);
-        program_collector.visit(tree);
+            ProgramCollector program_collector(ir, scopes);
+            program_collector.visit(tree);
+        } else {
+            // one walk, headers registered on first sight
+            ProgramCollector program_collector(ir, scopes);
+            program_collector.collect_headers = true;
+            program_collector.visit(tree);
+            program_collector.resolveForwardReferences();
+        }
     } catch (const std::exception& e) {
         std::cerr << "Error during IR construction: " << e.what() << "\n";
-        return 1;
+        return false;
+    }
+    if (args.report_timing) {
+        reportTiming("IR construction", elapsedMs(phase_start));
     }
 
+    return true;
+}
+
+static bool buildIRParallel(MappedCharStream& input, IR& ir, ScopeManager& scopes,
+                            const ArgParser::Args& args) {
     try {
-        if (args.decompose_mcx) {
-           passes::decomposeMCX(ir);
+        auto stats = frontend::parseParallel(input, ir, scopes, args.jobs);
+        if (stats.syntax_errors) {
+            if (args.report_timing) {
+                std::cerr << "[timing] parallel parsing hit a syntax error, parsing sequentially\n";
+            }
+            return buildIRWithAntlr(input, ir, scopes, args);
+        }
+        if (args.report_timing) {
+            reportTiming("splitting", stats.split_ms);
+            reportTiming("lexing + parsing", stats.parse_ms);
+            reportTiming("declarations", stats.declarations_ms);
+            reportTiming("IR construction", stats.lowering_ms);
+            std::cerr << "[timing] chunks: " << stats.chunks
+                      << " (" << stats.ll_chunks << " with LL fallback), threads: "
+                      << args.jobs << "\n";
         }
     } catch (const std::exception& e) {
-        std::cerr << "Error during MCX decomposition: " << e.what() << "\n";
-        return 1;
+        std::cerr << "Error during parallel parsing: " << e.what() << "\n";
+        return false;
     }
+    return true;
+}
 
+static bool runStreaming(MappedCharStream& input, IR& ir, ScopeManager& scopes,
+                         const ArgParser::Args& args) {
+    std::unique_ptr<Printer> printer;
     try {
-        if (args.merge_registers) {
-            passes::mergeRegisters(ir);
-        }
+        printer = selectPrinter(args.target, args.use_algebraic);
     } catch (const std::exception& e) {
-        std::cerr << "Error during register merging: " << e.what() << "\n";
-        return 1;
+        std::cerr << "Error: " << e.what() << "\n";
+        return false;
     }
 
+    std::ostream* output_ptr = &std::cout;
+    std::ofstream output_file_stream;
+
+    if (!args.output_file.empty()) {
+        output_file_stream.open(args.output_file);
+        if (!output_file_stream.good()) {
+            std::cerr << "Error: Could not open output file: " << args.output_file << "\n";
+            return false;
+        }
+        output_ptr = &output_file_stream;
+    }
+
+    auto phase_start = Clock::now();
     try {
-        if (args.eval_angles) {
-            passes::evaluateAngles(ir);
+        auto stats = frontend::streamProgram(input, ir, scopes, *printer, *output_ptr);
+        if (args.report_timing) {
+            reportTiming("streaming (parse + IR + output)", elapsedMs(phase_start));
+            std::cerr << "[timing] statements: " << stats.statements
+                      << ", LL fallbacks: " << stats.ll_fallbacks
+                      << ", nodes: " << stats.nodes << "\n";
         }
     } catch (const std::exception& e) {
-        std::cerr << "Error during angles evaluation: " << e.what() << "\n";
-        return 1;
+        std::cerr << "Error during streaming: " << e.what() << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+static bool buildIR(MappedCharStream& input, IR& ir, const ArgParser::Args& args) {
+    ScopeManager scopes;
+
+    if (!loadBuiltinGates(ir, scopes)) {
+        return false;
+    }
+
+    bool built = false;
+    if (args.fast_path) {
+        auto fast_start = Clock::now();
+        FastPathParser fast_parser(ir, scopes);
+        built = fast_parser.parse(input.contents());
+
+        if (args.report_timing) {
+            reportTiming(built ? "fast path" : "fast path (abandoned)", elapsedMs(fast_start));
+        }
+
+        if (!built && args.report_fast_path) {
+            // programs outside the fast path's subset are expected, not an error
+            std::cerr << "[fast-path] line " << fast_parser.failureLine() << ": "
+                      << fast_parser.failureReason() << ", falling back to ANTLR\n";
+        }
+
+        if (!built) {
+            // start over from a clean IR
+            ir = IR();
+            scopes = ScopeManager();
+            if (!loadBuiltinGates(ir, scopes)) {
+                return false;
+            }
+        }
+    }
+
+    if (built) {
+        return true;
+    }
+    return args.jobs > 1
+        ? buildIRParallel(input, ir, scopes, args)
+        : buildIRWithAntlr(input, ir, scopes, args);
+}
+
+static bool loadSnapshot(IR& ir, const ArgParser::Args& args) {
+    auto phase_start = Clock::now();
+    try {
+        ir_snapshot::load(args.load_ir, ir);
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading IR snapshot: " << e.what() << "\n";
+        return false;
+    }
+    if (args.report_timing) {
+        reportTiming("IR snapshot load", elapsedMs(phase_start));
+    }
+    if (args.report_memory) {
+        reportMemory("IR snapshot load");
+    }
+    return true;
+}
+
+static bool writeCachedOutput(std::string_view output, const ArgParser::Args& args) {
+    if (args.output_file.empty()) {
+        std::cout.write(output.data(), static_cast<std::streamsize>(output.size()));
+        return true;
+    }
+    std::ofstream out(args.output_file, std::ios::binary | std::ios::trunc);
+    out.write(output.data(), static_cast<std::streamsize>(output.size()));
+    if (!out.good()) {
+        std::cerr << "Error: Could not write output file: " << args.output_file << "\n";
+        return false;
+    }
+    return true;
+}
+
+static void reportCache(const OutputCache::Stats& stats) {
+    std::cerr << "[cache] hits: " << stats.hits << ", misses: " << stats.misses
+              << ", stored: " << stats.stored << ", evicted: " << stats.evicted
+              << " (" << stats.evicted_bytes / (1024.0 * 1024.0) << " MiB)\n";
+}
+
+static bool processFile(const ArgParser::Args& args, OutputCache* cache) {
+    // truncating the input would destroy it, and a mapped one (--stream) while it is read
+    std::error_code ec;
+    if (!args.input_file.empty() && !args.output_file.empty()
+        && std::filesystem::equivalent(args.input_file, args.output_file, ec)) {
+        std::cerr << "Error: Output file " << args.output_file << " is the input file\n";
+        return false;
+    }
+
+    gate_library::Options library_options;
+    if (!args.input_file.empty()) {
+        // includes are looked up next to the program first
+        library_options.include_dirs.push_back(
+            std::filesystem::path(args.input_file).parent_path().string());
+    }
+    library_options.include_dirs.push_back(".");
+    library_options.algebraic = args.use_algebraic;
+    library_options.precision = args.algebraic_precision;
+    library_options.use_cache = !args.no_library_cache;
+    gate_library::configure(std::move(library_options));
+
+    IR ir;
+    std::optional<std::string> cache_key;   // set when the output goes into the cache
+
+    if (!args.load_ir.empty()) {
+        if (!loadSnapshot(ir, args)) {
+            return false;
+        }
+    } else {
+        // input is mapped (or bulk-read from a pipe) and lexed in place
+        std::unique_ptr<MappedCharStream> input;
+        try {
+            input = args.input_file.empty()
+                ? MappedCharStream::fromStdin()
+                : MappedCharStream::fromFile(args.input_file);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return false;
+        }
+
+        if (args.report_memory) {
+            reportMemory("input");
+        }
+
+        // snapshots need the IR, so --emit-ir always builds it
+        if (cache && args.emit_ir.empty()) {
+            const std::string source = args.input_file.empty() ? "<stdin>" : args.input_file;
+            cache_key = cache->key(input->contents(), args);
+            if (cache_key) {
+                if (auto entry = cache->fetch(*cache_key)) {
+                    if (args.report_cache) {
+                        std::cerr << "[cache] hit: " << source << "\n";
+                    }
+                    return writeCachedOutput(entry->contents(), args);
+                }
+                if (args.report_cache) {
+                    std::cerr << "[cache] miss: " << source << "\n";
+                }
+            }
+        }
+
+        if (args.stream) {
+            ScopeManager scopes;
+            if (!loadBuiltinGates(ir, scopes)) {
+                return false;
+            }
+            bool streamed = runStreaming(*input, ir, scopes, args);
+            if (args.report_memory) {
+                reportMemory("streaming");
+            }
+            // streamed output to stdout is not kept, that would defeat bounded memory
+            if (streamed && cache_key && !args.output_file.empty()) {
+                cache->storeFile(*cache_key, args.output_file);
+            }
+            return streamed;
+        }
+
+        // lexer, tokens, parse trees and scopes only live inside buildIR
+        if (!buildIR(*input, ir, args)) {
+            return false;
+        }
+        if (args.report_memory) {
+            reportMemory("IR construction");
+        }
+
+        // the IR holds copies of everything it needs from the input
+        input.reset();
+        if (args.report_memory) {
+            reportMemory("input released");
+        }
+    }
+
+    auto phase_start = Clock::now();
+
+    // flat gate runs become GateStreams before the other passes walk them
+    passes::packGateStreams(ir);
+
+    if (!args.emit_ir.empty()) {
+        try {
+            ir_snapshot::save(ir, args.emit_ir);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return false;
+        }
+    }
+
+    if (!args.passes.empty()) {
+        try {
+            passes::PassOptions options;
+            options.unroll.budget = args.unroll_budget;
+            options.unroll.factor = args.unroll_factor;
+            passes::PassManager manager(options);
+            manager.run(ir, manager.parsePipeline(args.passes), args.report_timing ? &std::cerr : nullptr);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return false;
+        }
+    }
+
+    if (args.report_timing) {
+        reportTiming("passes", elapsedMs(phase_start));
+    }
+    if (args.report_memory) {
+        reportMemory("passes");
     }
 
     std::unique_ptr<Printer> printer;
@@ -155,31 +432,142 @@ int main(int argc, const char* argv[]) {
         printer = selectPrinter(args.target, args.use_algebraic);
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << "\n";
-        return 1;
+        return false;
     }
 
     std::ostream* output_ptr = &std::cout;
     std::ofstream output_file_stream;
+    std::ostringstream captured;   // output to stdout, kept for the cache
 
     if (!args.output_file.empty()) {
         output_file_stream.open(args.output_file);
         if (!output_file_stream.good()) {
             std::cerr << "Error: Could not open output file: " << args.output_file << "\n";
-            return 1;
+            return false;
         }
         output_ptr = &output_file_stream;
+    } else if (cache_key) {
+        output_ptr = &captured;
     }
 
+    phase_start = Clock::now();
     try {
         printer->print(ir, *output_ptr);
     } catch (const std::exception& e) {
         std::cerr << "Error during output generation: " << e.what() << "\n";
-        return 1;
+        return false;
+    }
+    if (args.report_timing) {
+        reportTiming("output", elapsedMs(phase_start));
+    }
+    if (args.report_memory) {
+        reportMemory("output");
     }
 
     if (!args.output_file.empty()) {
         output_file_stream.close();
+        if (cache_key) {
+            cache->storeFile(*cache_key, args.output_file);
+        }
+    } else if (cache_key) {
+        std::cout << captured.view();
+        cache->store(*cache_key, captured.view());
     }
 
-    return 0;
+    return true;
+}
+
+static bool runBatch(const ArgParser::Args& args, OutputCache* cache) {
+    std::ifstream manifest_file;
+    std::istream* manifest = &std::cin;
+    if (args.batch_file != "-") {
+        manifest_file.open(args.batch_file);
+        if (!manifest_file.good()) {
+            std::cerr << "Error: Could not open batch file: " << args.batch_file << "\n";
+            return false;
+        }
+        manifest = &manifest_file;
+    }
+
+    std::string extension;
+    try {
+        extension = selectPrinter(args.target, args.use_algebraic)->extension();
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return false;
+    }
+
+    // ANTLR keeps the prediction DFA in static data shared by all parser
+    // instances, so only the first files of a batch pay for the warm-up
+    size_t processed = 0;
+    size_t failed = 0;
+    auto batch_start = Clock::now();
+
+    std::string line;
+    while (std::getline(*manifest, line)) {
+        std::istringstream fields(line);
+        ArgParser::Args file_args = args;
+        if (!(fields >> file_args.input_file) || file_args.input_file.starts_with("#")) {
+            continue;   // blank line or comment
+        }
+        if (!(fields >> file_args.output_file)) {
+            auto output = std::filesystem::path(file_args.input_file).replace_extension(extension);
+            // e.g. openqasm3 output of a .qasm input: never write over the source
+            if (output == std::filesystem::path(file_args.input_file)) {
+                output.replace_extension("out." + extension);
+            }
+            file_args.output_file = output.string();
+        }
+
+        if (args.report_timing || args.report_memory) {
+            std::cerr << "[batch] " << file_args.input_file << "\n";
+        }
+        ++processed;
+        if (!processFile(file_args, cache)) {
+            std::cerr << "Error: Failed to process " << file_args.input_file << "\n";
+            ++failed;
+        }
+    }
+
+    if (args.report_timing) {
+        reportTiming("batch (" + std::to_string(processed) + " files)", elapsedMs(batch_start));
+    }
+    if (failed > 0) {
+        std::cerr << "Error: " << failed << " of " << processed << " files failed\n";
+    }
+    return failed == 0;
+}
+
+int main(int argc, const char* argv[]) {
+    ArgParser::Args args;
+    try {
+        args = ArgParser::parse(argc, argv);
+        if (!args.passes.empty()) {
+            passes::PassManager().parsePipeline(args.passes);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        ArgParser::printUsage(argv[0]);
+        return 1;
+    }
+
+    // one cache for the whole batch, so the report covers all files
+    std::unique_ptr<OutputCache> cache;
+    if (!args.cache_dir.empty()) {
+        try {
+            cache = std::make_unique<OutputCache>(args.cache_dir, args.cache_size_mb * 1024 * 1024);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    const bool succeeded = args.batch_file.empty()
+        ? processFile(args, cache.get())
+        : runBatch(args, cache.get());
+
+    if (cache && args.report_cache) {
+        reportCache(cache->stats());
+    }
+    return succeeded ? 0 : 1;
 }
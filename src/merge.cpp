@@ -4,6 +4,7 @@
  */
 #include "merge.hpp"
 
+#include <cstdint>
 #include <stdexcept>
 
 
@@ -11,12 +12,14 @@ std::vector<std::pair<idRegister, std::size_t>>
 collectMergeableRegisters(const IR& ir) {
     std::vector<std::pair<idRegister, std::size_t>> mergeable;
     
-    for (const auto& reg : ir.getAllRegisters()) {
+    const auto& registers = ir.getAllRegisters();
+    for (auto it = registers.begin(); it != registers.end(); ++it) {
+        const auto& reg = *it;
         if (reg.kind == RegisterKind::Nonparametric &&
             reg.type == RegisterType::Qubit) {
             try {
                 std::size_t size = std::stoul(reg.size);
-                mergeable.emplace_back(ir.getRegisterId(reg.name), size);
+                mergeable.emplace_back(it.id(), size);
             } catch (const std::invalid_argument&) {
                 // skip registers with non-integer sizes for now
             }
@@ -45,13 +48,37 @@ void rewriteRef(
     if (it != offset_map.end()) {
         std::size_t offset = it->second;
         ref.reg_id = merged_id;
+        ref.index.shift(static_cast<std::ptrdiff_t>(offset));
+    }
+}
+
+void rewriteStream(
+    GateStream& stream,
+    const std::unordered_map<idRegister, std::size_t>& offset_map,
+    idRegister merged_id
+) {
+    if (merged_id > UINT32_MAX) {
+        throw std::logic_error("Merged register id does not fit a gate stream");
+    }
+
+    // dense offset table, so the loop over operands does no hashing
+    constexpr std::int64_t NOT_MERGED = -1;
+    std::vector<std::int64_t> offsets;
+    for (const auto& [reg_id, offset] : offset_map) {
+        if (reg_id > UINT32_MAX) {
+            continue;   // reused slot, streams cannot refer to it
+        }
+        if (reg_id >= offsets.size()) {
+            offsets.resize(reg_id + 1, NOT_MERGED);
+        }
+        offsets[reg_id] = static_cast<std::int64_t>(offset);
+    }
 
-        try {
-            std::size_t index = std::stoul(ref.qubit_index);
-            ref.qubit_index = std::to_string(index + offset);
-        } catch (const std::invalid_argument&) {
-            // symbolic index: append offset as an expression
-            ref.qubit_index += " + " + std::to_string(offset);
+    for (std::size_t j = 0; j < stream.operand_regs.size(); ++j) {
+        const auto reg_id = stream.operand_regs[j];
+        if (reg_id < offsets.size() && offsets[reg_id] != NOT_MERGED) {
+            stream.operand_regs[j] = static_cast<std::uint32_t>(merged_id);
+            stream.operand_indices[j] += static_cast<std::int32_t>(offsets[reg_id]);
         }
     }
-}
\ No newline at end of file
+}
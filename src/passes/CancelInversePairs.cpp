@@ -0,0 +1,152 @@
+#include "Passes.hpp"
+#include "CircuitDag.hpp"
+#include <optional>
+
+namespace {
+
+constexpr std::size_t NO_INVERSE = static_cast<std::size_t>(-1);
+
+struct InverseTable {
+    std::vector<std::size_t> inverse;   // by gate slot, slot of the inverse gate
+    std::vector<bool> symmetric;        // qubit order does not matter
+
+    explicit InverseTable(const IR& ir)
+        : inverse(ir.getAllGates().slotCount(), NO_INVERSE),
+          symmetric(ir.getAllGates().slotCount(), false) {
+        // atomic gates only: a composite of the same name may mean something else
+        auto slotOf = [&](const char* name) -> std::optional<std::size_t> {
+            if (!ir.hasGate(name) || ir.getGate(name).kind != GateKind::Atomic) {
+                return std::nullopt;
+            }
+            return slotIndex(ir.getGateId(name));
+        };
+
+        for (const char* name : {"x", "y", "z", "h", "cx", "cy", "cz", "ch", "ccx", "mcx", "swap"}) {
+            if (auto slot = slotOf(name)) {
+                inverse[*slot] = *slot;
+            }
+        }
+        for (const char* name : {"cz", "swap"}) {
+            if (auto slot = slotOf(name)) {
+                symmetric[*slot] = true;
+            }
+        }
+        const std::pair<const char*, const char*> pairs[] = {{"s", "sdg"}, {"t", "tdg"}, {"sx", "sxdg"}};
+        for (const auto& [gate, adjoint] : pairs) {
+            auto a = slotOf(gate);
+            auto b = slotOf(adjoint);
+            if (a && b) {
+                inverse[*a] = *b;
+                inverse[*b] = *a;
+            }
+        }
+    }
+};
+
+/**
+ * Whether prev undoes node: its inverse on exactly the same qubits, with
+ * nothing in between on any of them.
+ */
+bool cancels(const CircuitDag& dag, const InverseTable& table,
+             CircuitDag::NodeId prev, CircuitDag::NodeId node) {
+    if (dag.isOpaque(prev) || dag.arity(prev) != dag.arity(node)) {
+        return false;
+    }
+    const auto slot = slotIndex(dag.gateId(node));
+    if (table.inverse[slot] != slotIndex(dag.gateId(prev))
+        || dag.paramCount(node) != 0 || dag.paramCount(prev) != 0) {
+        return false;
+    }
+    for (std::size_t k = 0; k < dag.arity(node); ++k) {
+        if (dag.predecessor(node, k) != prev) {
+            return false;
+        }
+        // with equal arity and every wire shared, only the order can differ
+        if (!table.symmetric[slot] && dag.wire(prev, k) != dag.wire(node, k)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * One sweep in program order. The predecessor links follow removals, so a
+ * pair exposed by cancelling the pair inside it (x h h x) goes in the same
+ * sweep.
+ */
+std::size_t sweep(CircuitDag& dag, const InverseTable& table) {
+    std::size_t removed = 0;
+    for (CircuitDag::NodeId node = 0; node < dag.size(); ++node) {
+        if (dag.isRemoved(node) || dag.isOpaque(node) || dag.arity(node) == 0) {
+            continue;
+        }
+        if (table.inverse[slotIndex(dag.gateId(node))] == NO_INVERSE) {
+            continue;
+        }
+        const auto prev = dag.predecessor(node, 0);
+        if (prev != CircuitDag::NONE && cancels(dag, table, prev, node)) {
+            dag.remove(prev);
+            dag.remove(node);
+            removed += 2;
+        }
+    }
+    return removed;
+}
+
+std::size_t cancelInBlock(IR& ir, Block& block, const InverseTable& table);
+
+std::size_t cancelInBody(IR& ir, std::vector<ProgramNodePtr>& body, const InverseTable& table) {
+    Block block;
+    block.body = std::move(body);
+    const auto removed = cancelInBlock(ir, block, table);
+    body = std::move(block.body);
+    return removed;
+}
+
+/// Loop and conditional bodies of block; to the DAG of block they are opaque.
+std::size_t cancelInNested(IR& ir, Block& block, const InverseTable& table) {
+    std::size_t removed = 0;
+    for (auto& node_ptr : block.body) {
+        if (auto* loop = node_cast<LoopApplication>(node_ptr.get())) {
+            removed += cancelInBlock(ir, loop->body, table);
+        } else if (auto* cond = node_cast<ConditionalApplication>(node_ptr.get())) {
+            removed += cancelInBody(ir, cond->then_body, table);
+            removed += cancelInBody(ir, cond->else_body, table);
+        }
+    }
+    return removed;
+}
+
+std::size_t cancelInDag(IR& ir, CircuitDag& dag, const InverseTable& table) {
+    std::size_t removed = 0;
+    while (auto count = sweep(dag, table)) {
+        removed += count;
+    }
+    if (removed > 0) {
+        dag.commit(ir.arena());
+    }
+    return removed;
+}
+
+std::size_t cancelInBlock(IR& ir, Block& block, const InverseTable& table) {
+    const auto removed = cancelInNested(ir, block, table);
+    if (block.body.empty()) {
+        return removed;
+    }
+    CircuitDag dag(ir, block);
+    return removed + cancelInDag(ir, dag, table);
+}
+
+} // namespace
+
+std::size_t passes::cancelInversePairs(IR& ir) {
+    const InverseTable table(ir);
+    return cancelInBlock(ir, ir.getGlobalBlock(), table);
+}
+
+std::size_t passes::cancelInversePairs(IR& ir, CircuitDag& dag) {
+    const InverseTable table(ir);
+    // the nested bodies are edited in place, the nodes of the global block keep their positions
+    const auto removed = cancelInNested(ir, ir.getGlobalBlock(), table);
+    return removed + cancelInDag(ir, dag, table);
+}
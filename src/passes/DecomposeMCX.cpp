@@ -1,5 +1,6 @@
 #include "Passes.hpp"
 #include "decompose.hpp"
+#include <algorithm>
 
 /**
  * @brief Decomposes all MCX gate applications in the block into chains of X, CX, and CCX gates.
@@ -31,35 +32,48 @@ static std::vector<ProgramNodePtr> decomposeBlock(
 ) {
     std::vector<ProgramNodePtr> new_body;
     for (auto& node_ptr : body) {
-        if (auto* gate_app = dynamic_cast<GateApplication*>(node_ptr.get());
+        if (auto* gate_app = node_cast<GateApplication>(node_ptr.get());
             gate_app && gate_app->gate_id == mcx_id) { // found an MCX application
             const auto n_controls = gate_app->operands.size() - 1;
             if (n_controls > 2) { // check if ancillas needed
                 const unsigned needed = n_controls - 2;
                 while (ancillas.size() < needed) {
                     ancillas.push_back(RegisterRef{
-                        .reg_id      = ancillas_register_id,
-                        .qubit_index = std::to_string(ancillas.size())
+                        .reg_id = ancillas_register_id,
+                        .index  = IndexExpr::literal(static_cast<std::ptrdiff_t>(ancillas.size()))
                     });
                 }
                 necessary_ancillas = std::max(necessary_ancillas, needed);
             }
             auto chain = buildMCXChain(*gate_app, ancillas, ir);
             for (auto& app : chain)
-                new_body.push_back(std::make_unique<GateApplication>(std::move(app)));
+                new_body.push_back(makeNode<GateApplication>(ir.arena(), std::move(app)));
 
-        } else if (auto* loop = dynamic_cast<LoopApplication*>(node_ptr.get())) { // recursively decompose inside loops
+        } else if (auto* loop = node_cast<LoopApplication>(node_ptr.get())) { // recursively decompose inside loops
             loop->body.body = decomposeBlock(
                 loop->body.body, mcx_id, ancillas, necessary_ancillas, ancillas_register_id, ir);
             new_body.push_back(std::move(node_ptr));
 
-        } else if (auto* cond = dynamic_cast<ConditionalApplication*>(node_ptr.get())) { // recursively decompose inside conditionals
+        } else if (auto* cond = node_cast<ConditionalApplication>(node_ptr.get())) { // recursively decompose inside conditionals
             cond->then_body = decomposeBlock(
                 cond->then_body, mcx_id, ancillas, necessary_ancillas, ancillas_register_id, ir);
             cond->else_body = decomposeBlock(
                 cond->else_body, mcx_id, ancillas, necessary_ancillas, ancillas_register_id, ir);
             new_body.push_back(std::move(node_ptr));
 
+        } else if (auto* stream = node_cast<GateStream>(node_ptr.get());
+                   stream && std::find(stream->gates.begin(), stream->gates.end(), mcx_id) != stream->gates.end()) {
+            // unpack streams containing an MCX, the chains replace single gates
+            std::vector<ProgramNodePtr> unpacked;
+            unpacked.reserve(stream->size());
+            for (std::size_t i = 0; i < stream->size(); ++i) {
+                unpacked.push_back(makeNode<GateApplication>(ir.arena(), stream->unpack(i)));
+            }
+            for (auto& node : decomposeBlock(
+                     unpacked, mcx_id, ancillas, necessary_ancillas, ancillas_register_id, ir)) {
+                new_body.push_back(std::move(node));
+            }
+
         } else { // other nodes remain unchanged
             new_body.push_back(std::move(node_ptr));
         }
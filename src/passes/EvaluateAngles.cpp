@@ -32,16 +32,28 @@ static std::string angle_to_string(long double val) {
 
 static void evaluateBlock(std::vector<ProgramNodePtr>& body) {
     for (auto& node_ptr : body) {
-        if (auto* gate_app = dynamic_cast<GateApplication*>(node_ptr.get())) {
-            for (auto& param : gate_app->params) {
-                long double val = evaluate_angle(param);
-                param = angle_to_string(val);
+        switch (node_ptr->kind) {
+            case NodeKind::Gate:
+                for (auto& param : static_cast<GateApplication&>(*node_ptr).params) {
+                    long double val = evaluate_angle(std::string(param));
+                    param = angle_to_string(val);
+                }
+                break;
+            case NodeKind::Loop:
+                evaluateBlock(static_cast<LoopApplication&>(*node_ptr).body.body);
+                break;
+            case NodeKind::Conditional: {
+                auto& cond = static_cast<ConditionalApplication&>(*node_ptr);
+                evaluateBlock(cond.then_body);
+                evaluateBlock(cond.else_body);
+                break;
             }
-        } else if (auto* loop = dynamic_cast<LoopApplication*>(node_ptr.get())) {
-            evaluateBlock(loop->body.body);
-        } else if (auto* cond = dynamic_cast<ConditionalApplication*>(node_ptr.get())) {
-            evaluateBlock(cond->then_body);
-            evaluateBlock(cond->else_body);
+            case NodeKind::Stream:
+                for (auto& param : static_cast<GateStream&>(*node_ptr).params) {
+                    long double val = evaluate_angle(std::string(param));
+                    param = angle_to_string(val);
+                }
+                break;
         }
     }
 }
@@ -0,0 +1,136 @@
+#include "Passes.hpp"
+#include "inline.hpp"
+
+namespace {
+
+struct Inliner {
+    IR& ir;
+    CompositeTemplates templates;
+    std::vector<bool> composite;   // by slotIndex of the gate id
+    GateApplication scratch;
+    std::size_t inlined = 0;
+
+    explicit Inliner(IR& ir) : ir(ir), composite(ir.getAllGates().slotCount(), false) {
+        const auto& gates = ir.getAllGates();
+        for (auto it = gates.begin(); it != gates.end(); ++it) {
+            composite[slotIndex(it.id())] = it->kind != GateKind::Atomic;
+        }
+    }
+
+    bool isComposite(idGate id) const {
+        return composite[slotIndex(id)];
+    }
+
+    // streams keep their literal operands, so the inlined gates stay in the stream
+    void inlineStream(GateStream& stream, std::vector<ProgramNodePtr>& new_body) {
+        auto copy = makeNode<GateStream>(ir.arena());
+        auto appendGate = [&](const GateApplication& app) {
+            if (GateStream::accepts(app)) {
+                copy->append(app);
+                return;
+            }
+            // a gate id beyond 32 bits, the stream is split around it
+            if (copy->size() > 0) {
+                new_body.push_back(std::move(copy));
+                copy = makeNode<GateStream>(ir.arena());
+            }
+            new_body.push_back(makeNode<GateApplication>(ir.arena(), app));
+        };
+
+        for (std::size_t i = 0; i < stream.size(); ++i) {
+            if (!isComposite(stream.gates[i])) {
+                copy->append(stream, i);
+                continue;
+            }
+            const auto call = stream.unpack(i);
+            for (const auto& flat : templates.flatten(ir, call.gate_id)) {
+                CompositeTemplates::instantiate(flat, call, scratch);
+                appendGate(scratch);
+            }
+            ++inlined;
+        }
+        if (copy->size() > 0) {
+            new_body.push_back(std::move(copy));
+        }
+    }
+
+    void inlineBlock(std::vector<ProgramNodePtr>& body) {
+        std::vector<ProgramNodePtr> new_body;
+        new_body.reserve(body.size());
+
+        for (auto& node_ptr : body) {
+            switch (node_ptr->kind) {
+                case NodeKind::Gate: {
+                    const auto& call = static_cast<const GateApplication&>(*node_ptr);
+                    if (!isComposite(call.gate_id)) {
+                        break;
+                    }
+                    for (const auto& flat : templates.flatten(ir, call.gate_id)) {
+                        auto app = makeNode<GateApplication>(ir.arena());
+                        CompositeTemplates::instantiate(flat, call, *app);
+                        new_body.push_back(std::move(app));
+                    }
+                    ++inlined;
+                    continue;
+                }
+                case NodeKind::Stream: {
+                    auto& stream = static_cast<GateStream&>(*node_ptr);
+                    bool any = false;
+                    for (auto gate_id : stream.gates) {
+                        if (isComposite(gate_id)) {
+                            any = true;
+                            break;
+                        }
+                    }
+                    if (!any) {
+                        break;
+                    }
+                    inlineStream(stream, new_body);
+                    continue;
+                }
+                case NodeKind::Loop:
+                    inlineBlock(static_cast<LoopApplication&>(*node_ptr).body.body);
+                    break;
+                case NodeKind::Conditional: {
+                    auto& cond = static_cast<ConditionalApplication&>(*node_ptr);
+                    inlineBlock(cond.then_body);
+                    inlineBlock(cond.else_body);
+                    break;
+                }
+            }
+            new_body.push_back(std::move(node_ptr));
+        }
+
+        body = std::move(new_body);
+    }
+};
+
+} // namespace
+
+std::size_t passes::inlineCompositeGates(IR& ir) {
+    Inliner inliner(ir);
+
+    inliner.inlineBlock(ir.getGlobalBlock().body);
+    std::vector<idGate> subroutines;
+    for (auto it = ir.getAllSubroutines().begin(); it != ir.getAllSubroutines().end(); ++it) {
+        subroutines.push_back(it.id());
+    }
+    for (auto id : subroutines) {
+        inliner.inlineBlock(ir.getSubroutine(id).body.body);
+    }
+
+    if (inliner.inlined > 0) {
+        // no call is left, definitions of composite gates are not printed any more
+        const auto& gates = ir.getAllGates();
+        std::vector<idGate> composites;
+        for (auto it = gates.begin(); it != gates.end(); ++it) {
+            if (it->kind != GateKind::Atomic && it->used) {
+                composites.push_back(it.id());
+            }
+        }
+        for (auto id : composites) {
+            ir.markGateUnused(id);
+        }
+    }
+    return inliner.inlined;
+}
@@ -1,5 +1,6 @@
 #include "Passes.hpp"
 #include "merge.hpp"
+#include <algorithm>
 
 /**
  * Recursively rewrites all RegisterRefs in a block.
@@ -15,15 +16,25 @@ static void rewriteRegistersRefsInBlock(
     idRegister merged_id
 ) {
     for (auto& node_ptr : body) {
-        if (auto* gate_app = dynamic_cast<GateApplication*>(node_ptr.get())) {
-            for (auto& op : gate_app->operands) {
-                rewriteRef(op, offset_map, merged_id);
+        switch (node_ptr->kind) {
+            case NodeKind::Gate:
+                for (auto& op : static_cast<GateApplication&>(*node_ptr).operands) {
+                    rewriteRef(op, offset_map, merged_id);
+                }
+                break;
+            case NodeKind::Loop:
+                rewriteRegistersRefsInBlock(
+                    static_cast<LoopApplication&>(*node_ptr).body.body, offset_map, merged_id);
+                break;
+            case NodeKind::Conditional: {
+                auto& cond = static_cast<ConditionalApplication&>(*node_ptr);
+                rewriteRegistersRefsInBlock(cond.then_body, offset_map, merged_id);
+                rewriteRegistersRefsInBlock(cond.else_body, offset_map, merged_id);
+                break;
             }
-        } else if (auto* loop = dynamic_cast<LoopApplication*>(node_ptr.get())) {
-            rewriteRegistersRefsInBlock(loop->body.body, offset_map, merged_id);
-        } else if (auto* cond = dynamic_cast<ConditionalApplication*>(node_ptr.get())) {
-            rewriteRegistersRefsInBlock(cond->then_body, offset_map, merged_id);
-            rewriteRegistersRefsInBlock(cond->else_body, offset_map, merged_id);
+            case NodeKind::Stream:
+                rewriteStream(static_cast<GateStream&>(*node_ptr), offset_map, merged_id);
+                break;
         }
     }
 }
@@ -40,20 +51,19 @@ void passes::mergeRegisters(IR& ir) {
     for (const auto& [_, size] : mergeable_regs)
         total_size += size;
 
-    // Repurpose the FIRST register as the merged one -id stays stable
-    idRegister merged_id = mergeable_regs[0].first;
-    RegisterDef& merged = ir.getRegister(merged_id);
-    merged.name = "__merged_qubits";
-    merged.size = std::to_string(total_size);
+    // Repurpose the register with the smallest id as the merged one - the only
+    // one that surely fits the 32-bit register ids of gate streams
+    idRegister merged_id = std::min_element(mergeable_regs.begin(), mergeable_regs.end())->first;
+    ir.renameRegister(merged_id, "__merged_qubits");
+    ir.getRegister(merged_id).size = std::to_string(total_size);
 
     // Rewrite all refs (including refs that already point to merged_id - offset is 0, no-op)
     rewriteRegistersRefsInBlock(ir.getGlobalBlock().body, offset_map, merged_id);
 
-    // Zero out the remaining registers - do NOT remove (would shift ids),
-    // during emitting, registers with size "0" are skipped
-    for (std::size_t i = 1; i < mergeable_regs.size(); ++i) {
-        RegisterDef& reg = ir.getRegister(mergeable_regs[i].first);
-        reg.size = "0";
-        reg.name = "__unused";
+    // ids are stable, the other registers can simply go
+    for (const auto& [reg_id, _] : mergeable_regs) {
+        if (reg_id != merged_id) {
+            ir.removeRegister(reg_id);
+        }
     }
 }
\ No newline at end of file
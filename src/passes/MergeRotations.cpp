@@ -0,0 +1,282 @@
+#include "Passes.hpp"
+#include "CircuitDag.hpp"
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <numbers>
+#include <optional>
+
+namespace {
+
+// rotation axes, as bits so a gate can commute with several
+constexpr std::uint8_t AXIS_X = 1u << 0;
+constexpr std::uint8_t AXIS_Y = 1u << 1;
+constexpr std::uint8_t AXIS_Z = 1u << 2;
+
+struct CommuteTable {
+    std::vector<std::uint8_t> rotation;   // by gate slot, axis of rx / ry / rz
+    std::vector<std::uint8_t> all;        // axes the gate commutes with on each of its qubits
+    std::vector<std::uint8_t> controls;   // ... on its controls (all qubits but the last)
+    std::vector<std::uint8_t> target;     // ... on its last qubit
+
+    explicit CommuteTable(const IR& ir)
+        : rotation(ir.getAllGates().slotCount(), 0),
+          all(ir.getAllGates().slotCount(), 0),
+          controls(ir.getAllGates().slotCount(), 0),
+          target(ir.getAllGates().slotCount(), 0) {
+        // atomic gates only: a composite of the same name may mean something else
+        auto slotOf = [&](const char* name) -> std::optional<std::size_t> {
+            if (!ir.hasGate(name) || ir.getGate(name).kind != GateKind::Atomic) {
+                return std::nullopt;
+            }
+            return slotIndex(ir.getGateId(name));
+        };
+        auto mark = [&](std::vector<std::uint8_t>& table, std::initializer_list<const char*> names,
+                        std::uint8_t axes) {
+            for (const char* name : names) {
+                if (auto slot = slotOf(name)) {
+                    table[*slot] |= axes;
+                }
+            }
+        };
+
+        mark(rotation, {"rx"}, AXIS_X);
+        mark(rotation, {"ry"}, AXIS_Y);
+        mark(rotation, {"rz"}, AXIS_Z);
+
+        // diagonal gates
+        mark(all, {"z", "s", "sdg", "t", "tdg", "p", "u1", "rz", "cz", "ccz", "crz", "cp", "cu1"}, AXIS_Z);
+        mark(all, {"x", "sx", "sxdg", "rx"}, AXIS_X);
+        mark(all, {"y", "ry"}, AXIS_Y);
+        // controlled gates with the target last
+        mark(controls, {"cx", "cy", "ch", "ccx", "mcx", "crx", "cry"}, AXIS_Z);
+        mark(target, {"cx", "ccx", "mcx"}, AXIS_X);
+        mark(target, {"cy"}, AXIS_Y);
+    }
+
+    bool commutes(std::size_t slot, std::size_t k, std::size_t arity, std::uint8_t axis) const {
+        const auto axes = all[slot] | (k + 1 == arity ? target[slot] : controls[slot]);
+        return (axes & axis) != 0;
+    }
+};
+
+std::optional<double> numericAngle(std::string_view text) {
+    double value;
+    const auto* end = text.data() + text.size();
+    auto [ptr, ec] = std::from_chars(text.data(), end, value);
+    if (ec != std::errc() || ptr != end) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+/// Whether a numeric angle is a whole number of 4*pi turns, where every rotation is the identity.
+bool isIdentityAngle(double angle) {
+    constexpr double FULL_TURN = 4 * std::numbers::pi;
+    const double rest = std::fmod(std::fabs(angle), FULL_TURN);
+    return rest < 1e-12 || FULL_TURN - rest < 1e-12;
+}
+
+bool isIdentityAngle(std::string_view text) {
+    const auto value = numericAngle(text);
+    return value && isIdentityAngle(*value);
+}
+
+/**
+ * Text of the angle a + b: a literal when both are numeric, "0" for x and
+ * -x or -(x), otherwise the symbolic sum.
+ */
+std::string addAngles(std::string_view a, std::string_view b) {
+    const auto x = numericAngle(a);
+    const auto y = numericAngle(b);
+    if (x && y) {
+        const double sum = *x + *y;
+        if (isIdentityAngle(sum)) {
+            return "0";
+        }
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "%.17g", sum);
+        return buf;
+    }
+
+    // "-x" negates x only for a single name or literal: -a+b is not -(a+b)
+    auto negates = [](std::string_view negated, std::string_view value) {
+        if (negated.empty() || negated[0] != '-') {
+            return false;
+        }
+        const auto rest = negated.substr(1);
+        if (rest == value) {
+            return value.find_first_of("+-*/^%() ") == std::string_view::npos;
+        }
+        return rest.size() == value.size() + 2 && rest.front() == '(' && rest.back() == ')'
+            && rest.substr(1, value.size()) == value;
+    };
+    if (negates(a, b) || negates(b, a)) {
+        return "0";
+    }
+
+    std::string text(a);
+    // an expression keeps its precedence, e.g. a+(b-c)
+    if (b.find_first_of("+-*/^% ") == std::string_view::npos) {
+        text += '+';
+        text += b;
+    } else {
+        text += "+(";
+        text += b;
+        text += ')';
+    }
+    return text;
+}
+
+/// Whether two opaque nodes act on the same qubit: their only operand is the same index expression.
+bool sameOperand(const GateApplication& a, const GateApplication& b) {
+    return a.operands[0].reg_id == b.operands[0].reg_id && a.operands[0].index == b.operands[0].index;
+}
+
+/**
+ * One sweep in program order. Per wire, open[w] is the latest rotation on
+ * it that every later gate on the wire so far commutes with; a rotation of
+ * the same axis on the same qubit is folded into it.
+ *
+ * Gates with non-literal indices are opaque and act on their whole
+ * register; two such rotations merge if they have the same operand (q[i]
+ * and q[i]) and are still open on every wire of the register.
+ */
+std::size_t sweep(CircuitDag& dag, const CommuteTable& table) {
+    std::vector<CircuitDag::NodeId> open(dag.wireCount(), CircuitDag::NONE);
+    std::vector<std::uint8_t> open_axis(dag.wireCount(), 0);
+
+    auto close = [&](CircuitDag::NodeId node) {
+        for (std::size_t k = 0; k < dag.arity(node); ++k) {
+            open[dag.wire(node, k)] = CircuitDag::NONE;
+        }
+    };
+
+    std::size_t removed = 0;
+    for (CircuitDag::NodeId node = 0; node < dag.size(); ++node) {
+        if (dag.isRemoved(node) || dag.arity(node) == 0) {
+            continue;
+        }
+        const auto* app = dag.isOpaque(node) ? dag.application(node) : nullptr;
+        if (dag.isOpaque(node) && !app) {
+            close(node);   // loops and conditionals
+            continue;
+        }
+
+        const auto slot = slotIndex(dag.gateId(node));
+        const auto axis = table.rotation[slot];
+        const bool rotation = axis != 0 && dag.paramCount(node) == 1
+            && (dag.isOpaque(node) ? app->operands.size() == 1 : dag.arity(node) == 1);
+
+        if (!rotation) {
+            for (std::size_t k = 0; k < dag.arity(node); ++k) {
+                const auto w = dag.wire(node, k);
+                // an opaque gate may act on any qubit of its registers
+                if (open[w] != CircuitDag::NONE
+                    && (dag.isOpaque(node) || !table.commutes(slot, k, dag.arity(node), open_axis[w]))) {
+                    open[w] = CircuitDag::NONE;
+                }
+            }
+            continue;
+        }
+
+        if (isIdentityAngle(dag.param(node, 0))) {
+            dag.remove(node);
+            ++removed;
+            continue;
+        }
+
+        // the rotation open on all wires of node, if any
+        auto target = open[dag.wire(node, 0)];
+        for (std::size_t k = 1; k < dag.arity(node) && target != CircuitDag::NONE; ++k) {
+            if (open[dag.wire(node, k)] != target) {
+                target = CircuitDag::NONE;
+            }
+        }
+        const bool merges = target != CircuitDag::NONE
+            && dag.gateId(target) == dag.gateId(node)
+            && dag.isOpaque(target) == dag.isOpaque(node)
+            && (!app || sameOperand(*dag.application(target), *app));
+
+        if (!merges) {
+            for (std::size_t k = 0; k < dag.arity(node); ++k) {
+                open[dag.wire(node, k)] = node;
+                open_axis[dag.wire(node, k)] = axis;
+            }
+            continue;
+        }
+
+        const auto sum = addAngles(dag.param(target, 0), dag.param(node, 0));
+        dag.remove(node);
+        ++removed;
+        if (isIdentityAngle(sum)) {
+            close(target);
+            dag.remove(target);
+            ++removed;
+        } else {
+            dag.setParam(target, 0, sum);
+        }
+    }
+    return removed;
+}
+
+std::size_t mergeInBlock(IR& ir, Block& block, const CommuteTable& table);
+
+std::size_t mergeInBody(IR& ir, std::vector<ProgramNodePtr>& body, const CommuteTable& table) {
+    Block block;
+    block.body = std::move(body);
+    const auto removed = mergeInBlock(ir, block, table);
+    body = std::move(block.body);
+    return removed;
+}
+
+/// Loop and conditional bodies of block; to the DAG of block they are opaque.
+std::size_t mergeInNested(IR& ir, Block& block, const CommuteTable& table) {
+    std::size_t removed = 0;
+    for (auto& node_ptr : block.body) {
+        if (auto* loop = node_cast<LoopApplication>(node_ptr.get())) {
+            removed += mergeInBlock(ir, loop->body, table);
+        } else if (auto* cond = node_cast<ConditionalApplication>(node_ptr.get())) {
+            removed += mergeInBody(ir, cond->then_body, table);
+            removed += mergeInBody(ir, cond->else_body, table);
+        }
+    }
+    return removed;
+}
+
+std::size_t mergeInDag(IR& ir, CircuitDag& dag, const CommuteTable& table) {
+    std::size_t removed = 0;
+    // a sweep closes a rotation when one of another axis follows it, removing
+    // that one can bring two of the first axis together for the next sweep
+    while (auto count = sweep(dag, table)) {
+        removed += count;
+    }
+    if (removed > 0) {
+        dag.commit(ir.arena());
+    }
+    return removed;
+}
+
+std::size_t mergeInBlock(IR& ir, Block& block, const CommuteTable& table) {
+    const auto removed = mergeInNested(ir, block, table);
+    if (block.body.empty()) {
+        return removed;
+    }
+    CircuitDag dag(ir, block);
+    return removed + mergeInDag(ir, dag, table);
+}
+
+} // namespace
+
+std::size_t passes::mergeRotations(IR& ir) {
+    const CommuteTable table(ir);
+    return mergeInBlock(ir, ir.getGlobalBlock(), table);
+}
+
+std::size_t passes::mergeRotations(IR& ir, CircuitDag& dag) {
+    const CommuteTable table(ir);
+    // the nested bodies are edited in place, the nodes of the global block keep their positions
+    const auto removed = mergeInNested(ir, ir.getGlobalBlock(), table);
+    return removed + mergeInDag(ir, dag, table);
+}
@@ -0,0 +1,67 @@
+#include "Passes.hpp"
+
+// shorter runs are not worth the six arrays of a stream
+static constexpr std::size_t MIN_STREAM_GATES = 16;
+
+/**
+ * Moves the run body[begin, end) of packable gate applications into one
+ * GateStream, or keeps it as it is when it is too short.
+ */
+static void flushRun(std::vector<ProgramNodePtr>& body,
+                     std::size_t begin, std::size_t end,
+                     std::vector<ProgramNodePtr>& new_body,
+                     Arena& arena) {
+    if (end - begin < MIN_STREAM_GATES) {
+        for (auto i = begin; i < end; ++i) {
+            new_body.push_back(std::move(body[i]));
+        }
+        return;
+    }
+
+    auto stream = makeNode<GateStream>(arena);
+    stream->gates.reserve(end - begin);
+    stream->operand_offsets.reserve(end - begin + 1);
+    stream->param_offsets.reserve(end - begin + 1);
+    for (auto i = begin; i < end; ++i) {
+        stream->append(static_cast<const GateApplication&>(*body[i]));
+    }
+    new_body.push_back(std::move(stream));
+}
+
+static void packBlock(std::vector<ProgramNodePtr>& body, Arena& arena) {
+    std::vector<ProgramNodePtr> new_body;
+    new_body.reserve(body.size());
+
+    std::size_t run_begin = 0;
+    for (std::size_t i = 0; i < body.size(); ++i) {
+        auto* node = body[i].get();
+        if (auto* gate_app = node_cast<GateApplication>(node); gate_app && GateStream::accepts(*gate_app)) {
+            continue;
+        }
+
+        flushRun(body, run_begin, i, new_body, arena);
+        run_begin = i + 1;
+
+        switch (node->kind) {
+            case NodeKind::Loop:
+                packBlock(static_cast<LoopApplication&>(*node).body.body, arena);
+                break;
+            case NodeKind::Conditional: {
+                auto& cond = static_cast<ConditionalApplication&>(*node);
+                packBlock(cond.then_body, arena);
+                packBlock(cond.else_body, arena);
+                break;
+            }
+            default:
+                break;
+        }
+        new_body.push_back(std::move(body[i]));
+    }
+    flushRun(body, run_begin, body.size(), new_body, arena);
+
+    body = std::move(new_body);
+}
+
+void passes::packGateStreams(IR& ir) {
+    packBlock(ir.getGlobalBlock().body, ir.arena());
+}
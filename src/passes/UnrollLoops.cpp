@@ -1,2 +1,11 @@
 #include "Passes.hpp"
 #include "unroll.hpp"
+
+passes::UnrollStats passes::unrollLoops(IR& ir, const UnrollOptions& options) {
+    auto stats = LoopUnroller(ir, options).run();
+    if (stats.unrolled_loops > 0) {
+        // the unrolled gates have literal indices, runs of them become streams
+        packGateStreams(ir);
+    }
+    return stats;
+}
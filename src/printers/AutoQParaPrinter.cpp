@@ -33,6 +33,18 @@ idGate AutoQParaPrinter::getLocalGateId(idGate irGateId) const {
 }
 
 
+idRegister AutoQParaPrinter::getLocalRegisterId(idRegister irRegisterId) const {
+    auto it = local_registers.find(irRegisterId);
+    if (it == local_registers.end()) {
+        throw std::out_of_range(
+            "Register ID " + std::to_string(irRegisterId) +
+            " not found in local register mapping"
+        );
+    }
+    return it->second;
+}
+
+
 idGate AutoQParaPrinter::addLocalGateId(idGate irGateId) {
     auto it = local_gates.find(irGateId);
     if (it != local_gates.end()) {
@@ -63,17 +75,17 @@ void AutoQParaPrinter::printRegister(const RegisterDef& reg, int indentLvl, std:
         << ", .name = \"" << reg.name << "\")";
 }
 
-void AutoQParaPrinter::printRegisterTable(const IR& ir, std::ostream& out) const {
+void AutoQParaPrinter::printRegisterTable(const IR& ir, std::ostream& out) {
     out << indent(1) << ".registers = {\n";
 
+    // reg_ids in the output are positions in this table, ids in the IR may have gaps
     const auto& regs = ir.getAllRegisters();
-    for (size_t i = 0; i < regs.size(); ++i) {
-        if (regs[i].size == "0") {
-            // skip zero-size registers (e.g. removed by optimizations)
-            continue;
-        }
-        printRegister(regs[i], 2, out);
-        if (i + 1 < regs.size()) out << ",";
+    local_registers.clear();
+    for (auto it = regs.begin(); it != regs.end(); ++it) {
+        const idRegister position = local_registers.size();
+        local_registers[it.id()] = position;
+        printRegister(*it, 2, out);
+        if (position + 1 < regs.size()) out << ",";
         out << "\n";
     }
 
@@ -164,10 +176,8 @@ void AutoQParaPrinter::printGate(const GateDef& gate, const IR& ir, int indentLv
 void AutoQParaPrinter::printGateTable(const IR& ir, std::ostream& out) {
     out << indent(1) << ".gates = {\n";
 
-    const auto& gates = ir.getAllGates();
-    for (size_t i = 0; i < gates.size(); ++i) {
-        if (!gates[i].used) continue;
-        printGate(gates[i], ir, 2, out);
+    for (const auto& gate : ir.usedGates()) {
+        printGate(gate, ir, 2, out);
         out << ",\n";
     }
 
@@ -218,6 +228,38 @@ void AutoQParaPrinter::printLoopValues(const LoopApplication& loop, int indentLv
     }
 }
 
+void AutoQParaPrinter::printSingleGate(const GateApplication& gateApp, std::ostream& out) const {
+    out << indent(2) << "SingleGate(\n";
+    out << indent(4) << ".gate_id = " << getLocalGateId(gateApp.gate_id) << ",\n";
+    out << indent(4) << ".inputs = {\n";
+
+    for (size_t i = 0; i < gateApp.operands.size(); ++i) {
+        const auto& op = gateApp.operands[i];
+        out << indent(6) << "RegisterRef(.reg_id = "
+            << getLocalRegisterId(op.reg_id) << ", .qubit_id = "
+            << op.index.str() << ")";
+        if (i + 1 < gateApp.operands.size()) out << ",";
+        out << "\n";
+    }
+
+    out << indent(4) << "}\n";
+    out << indent(2) << "),\n";
+}
+
+void AutoQParaPrinter::printLoopGate(const GateApplication& gate, std::ostream& out) const {
+    out << indent(4) << ".gate_id = " << gate.gate_id << ",\n";
+    out << indent(4) << ".inputs = {\n";
+
+    for (const auto& op : gate.operands) {
+        out << indent(6) << "RegisterRef(.reg_id = "
+            << getLocalRegisterId(op.reg_id)
+            << ", .qubit_id = "
+            << op.index.str() << "),\n";
+    }
+
+    out << indent(4) << "},\n";
+}
+
 // TODO: merge transducer definitions for same semantics
 void AutoQParaPrinter::printTransducerDefs(const IR& ir, std::ostream& out) const {
     out << indent(1) << ".transducer_defs = {\n";
@@ -225,39 +267,23 @@ void AutoQParaPrinter::printTransducerDefs(const IR& ir, std::ostream& out) cons
     const auto& program = ir.getGlobalBlock();
 
     for (const auto& p : program.body) {
-        if (auto gateApp = dynamic_cast<GateApplication*>(p.get())) {
-            out << indent(2) << "SingleGate(\n";
-            out << indent(4) << ".gate_id = " << getLocalGateId(gateApp->gate_id) << ",\n";
-            out << indent(4) << ".inputs = {\n";
-
-            for (size_t i = 0; i < gateApp->operands.size(); ++i) {
-                const auto& op = gateApp->operands[i];
-                out << indent(6) << "RegisterRef(.reg_id = "
-                    << op.reg_id << ", .qubit_id = "
-                    << op.qubit_index << ")";
-                if (i + 1 < gateApp->operands.size()) out << ",";
-                out << "\n";
+        if (auto gateApp = node_cast<GateApplication>(p.get())) {
+            printSingleGate(*gateApp, out);
+        } else if (auto stream = node_cast<GateStream>(p.get())) {
+            for (size_t i = 0; i < stream->size(); ++i) {
+                printSingleGate(stream->unpack(i), out);
             }
-
-            out << indent(4) << "}\n";
-            out << indent(2) << "),\n";
-        } else if (auto loop = dynamic_cast<LoopApplication*>(p.get())) {
+        } else if (auto loop = node_cast<LoopApplication>(p.get())) {
             out << indent(2) << "FromLoop(\n";
             printVariables(loop->body.variables, out, 4);
 
             for (const auto& stmt : loop->body.body) {
-                if (auto gate = dynamic_cast<GateApplication*>(stmt.get())) {
-                    out << indent(4) << ".gate_id = " << gate->gate_id << ",\n";
-                    out << indent(4) << ".inputs = {\n";
-
-                    for (const auto& op : gate->operands) {
-                        out << indent(6) << "RegisterRef(.reg_id = "
-                            << op.reg_id
-                            << ", .qubit_id = "
-                            << op.qubit_index << "),\n";
+                if (auto gate = node_cast<GateApplication>(stmt.get())) {
+                    printLoopGate(*gate, out);
+                } else if (auto loop_stream = node_cast<GateStream>(stmt.get())) {
+                    for (size_t i = 0; i < loop_stream->size(); ++i) {
+                        printLoopGate(loop_stream->unpack(i), out);
                     }
-
-                    out << indent(4) << "},\n";
                 }
             }
 
@@ -291,10 +317,10 @@ void AutoQParaPrinter::printSubroutineTable(const IR& ir, std::ostream& out) con
 
     out << indent(1) << ".subroutines = {\n";
 
-    for (size_t i = 0; i < subroutines.size(); ++i) {
-        if (!subroutines[i].used) continue;
-        out << indent(2) << "Subroutine(.name = \"" << subroutines[i].name
-            << "\", .num_params = " << subroutines[i].parameters.size() << "),\n";
+    for (const auto& subroutine : subroutines) {
+        if (!subroutine.used) continue;
+        out << indent(2) << "Subroutine(.name = \"" << subroutine.name
+            << "\", .num_params = " << subroutine.parameters.size() << "),\n";
     }
 
     out << indent(1) << "},\n";
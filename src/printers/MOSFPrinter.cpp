@@ -35,17 +35,22 @@ static double parse_angle_expr(const std::string& s) {
 
 std::string MOSFPrinter::qubitVarName(const RegisterRef &ref, const IR &ir) const {
     const auto& reg = ir.getRegister(ref.reg_id);
-    return reg.name + "[" + ref.qubit_index + "]";
+    return reg.name + "[" + ref.index.str() + "]";
 }
+int MOSFPrinter::qubitLevel(const RegisterRef &ref) const {
+    if (!ref.index.isLiteral())
+        throw std::runtime_error("MOSFPrinter: qubit index must be constant, got " + ref.index.str());
+    return static_cast<int>(qubit_layout.base(ref.reg_id)) + static_cast<int>(ref.index.offset);
+}
+
 void MOSFPrinter::assignLevels(const IR& ir) {
-    this->qubit_levels.clear();
+    this->level_vars.clear();
+    this->qubit_layout = QubitLayout(ir);
+    this->level_vars.reserve(qubit_layout.qubitCount());
 
-    int assigned_level = 0;
-    for (const auto& reg : ir.getAllRegisters()) {
-        if (reg.type != RegisterType::Qubit) continue;
+    for (const auto& reg : ir.qubitRegisters()) {
         for (size_t i = 0; i < std::stoul(reg.size); ++i) {
-            std::string var_name = reg.name + "[" + std::to_string(i) + "]";
-            qubit_levels[var_name] = assigned_level++;
+            level_vars.push_back(reg.name + "[" + std::to_string(i) + "]");
         }
     }
 }
@@ -53,12 +58,8 @@ void MOSFPrinter::assignLevels(const IR& ir) {
 ordered_json MOSFPrinter::buildVars() const {
     ordered_json vars_json = ordered_json::object();
 
-    std::vector<std::pair<std::string, int>> sorted(qubit_levels.begin(), qubit_levels.end());
-    std::sort(sorted.begin(), sorted.end(),
-              [](const auto& a, const auto& b) { return a.second < b.second; });
-
-    for (const auto& [name, level] : sorted)
-        vars_json[name] = level;
+    for (size_t level = 0; level < level_vars.size(); ++level)
+        vars_json[level_vars[level]] = level;
 
     return vars_json;
 }
@@ -88,21 +89,19 @@ ordered_json MOSFPrinter::buildDefs() const {
     return defs_json;
 }
 
-ordered_json MOSFPrinter::emitMCX(GateApplication app, const IR& ir) {
+ordered_json MOSFPrinter::emitMCX(const GateApplication& app, const IR& ir) {
     // Convention: last operand = target, preceding = controls
     if (app.operands.size() < 1)
         throw std::runtime_error("MOSFPrinter: [M(C)]X gate expects at least 1 operand.");
 
-    std::vector<std::string> ctrl_vars;
-    for (size_t i = 0; i + 1 < app.operands.size(); ++i)
-        ctrl_vars.push_back(qubitVarName(app.operands[i], ir));
     const std::string tgt_var = qubitVarName(app.operands.back(), ir);
 
-    const int xt = qubit_levels.at(tgt_var);
+    const int xt = qubitLevel(app.operands.back());
 
     std::vector<std::pair<int, std::string>> above_t, below_t;
-    for (const auto& ctrl : ctrl_vars) {
-        const int xc = qubit_levels.at(ctrl);
+    for (size_t i = 0; i + 1 < app.operands.size(); ++i) {
+        const std::string ctrl = qubitVarName(app.operands[i], ir);
+        const int xc = qubitLevel(app.operands[i]);
         if      (xc < xt) above_t.push_back({xc, ctrl});
         else if (xc > xt) below_t.push_back({xc, ctrl});
         else throw std::runtime_error(
@@ -160,7 +159,7 @@ ordered_json MOSFPrinter::emitMCX(GateApplication app, const IR& ir) {
     return res;
 }
 
-ordered_json MOSFPrinter::emitH(GateApplication app, const IR& ir) {
+ordered_json MOSFPrinter::emitH(const GateApplication& app, const IR& ir) {
     if (app.operands.size() != 1)
         throw std::runtime_error("MOSFPrinter: H gate expects exactly 1 operand.");
 
@@ -186,14 +185,14 @@ ordered_json MOSFPrinter::emitH(GateApplication app, const IR& ir) {
     };
 }
 
-ordered_json MOSFPrinter::emitRX(GateApplication app, const IR& ir) {
+ordered_json MOSFPrinter::emitRX(const GateApplication& app, const IR& ir) {
     if (app.operands.size() != 1)
         throw std::runtime_error("MOSFPrinter: RX gate expects exactly 1 operand.");
     if (app.params.size() != 1)
         throw std::runtime_error("MOSFPrinter: RX gate expects exactly 1 parameter (angle).");
 
     const std::string tgt_var = qubitVarName(app.operands[0], ir);
-    const std::string angle = app.params[0];
+    const std::string angle(app.params[0]);
     double angle_val = parse_angle_expr(angle);
     return ordered_json{
         {"type",   "traverse_to"},
@@ -206,14 +205,14 @@ ordered_json MOSFPrinter::emitRX(GateApplication app, const IR& ir) {
     };
 }
 
-ordered_json MOSFPrinter::emitRY(GateApplication app, const IR& ir) {
+ordered_json MOSFPrinter::emitRY(const GateApplication& app, const IR& ir) {
     if (app.operands.size() != 1)
         throw std::runtime_error("MOSFPrinter: RY gate expects exactly 1 operand.");
     if (app.params.size() != 1)
         throw std::runtime_error("MOSFPrinter: RY gate expects exactly 1 parameter (angle).");
 
     const std::string tgt_var = qubitVarName(app.operands[0], ir);
-    const std::string angle = app.params[0];
+    const std::string angle(app.params[0]);
     double angle_val = parse_angle_expr(angle);
 
     return ordered_json{
@@ -226,7 +225,7 @@ ordered_json MOSFPrinter::emitRY(GateApplication app, const IR& ir) {
     };
 }
 
-ordered_json MOSFPrinter::emitZ(GateApplication app, const IR& ir) {
+ordered_json MOSFPrinter::emitZ(const GateApplication& app, const IR& ir) {
     if (app.operands.size() != 1)
         throw std::runtime_error("MOSFPrinter: Z gate expects exactly 1 operand.");
 
@@ -253,7 +252,7 @@ ordered_json MOSFPrinter::emitZ(GateApplication app, const IR& ir) {
     };
 }
 
-ordered_json MOSFPrinter::emitS(GateApplication app, const IR& ir) {
+ordered_json MOSFPrinter::emitS(const GateApplication& app, const IR& ir) {
     if (app.operands.size() != 1)
         throw std::runtime_error("MOSFPrinter: S gate expects exactly 1 operand.");
 
@@ -280,7 +279,7 @@ ordered_json MOSFPrinter::emitS(GateApplication app, const IR& ir) {
     };
 }
 
-ordered_json MOSFPrinter::emitY(GateApplication app, const IR& ir) {
+ordered_json MOSFPrinter::emitY(const GateApplication& app, const IR& ir) {
     if (app.operands.size() != 1)
         throw std::runtime_error("MOSFPrinter: Y gate expects exactly 1 operand.");
 
@@ -310,14 +309,14 @@ ordered_json MOSFPrinter::emitY(GateApplication app, const IR& ir) {
     };
 }
 
-ordered_json MOSFPrinter::emitCZ(GateApplication app, const IR& ir) {
+ordered_json MOSFPrinter::emitCZ(const GateApplication& app, const IR& ir) {
     if (app.operands.size() != 2)
         throw std::runtime_error("MOSFPrinter: CZ gate expects exactly 2 operands (control, target).");
 
     std::string ctrl_var = qubitVarName(app.operands[0], ir);
     std::string tgt_var  = qubitVarName(app.operands[1], ir);
 
-    if (qubit_levels.at(ctrl_var) > qubit_levels.at(tgt_var)) {
+    if (qubitLevel(app.operands[0]) > qubitLevel(app.operands[1])) {
         ctrl_var.swap(tgt_var);
     }
 
@@ -347,7 +346,7 @@ ordered_json MOSFPrinter::emitCZ(GateApplication app, const IR& ir) {
     };
 }
 
-ordered_json MOSFPrinter::emitTdg(GateApplication app, const IR& ir) {
+ordered_json MOSFPrinter::emitTdg(const GateApplication& app, const IR& ir) {
     if (app.operands.size() != 1)
         throw std::runtime_error("MOSFPrinter: Tdg gate expects exactly 1 operand.");
 
@@ -376,14 +375,14 @@ ordered_json MOSFPrinter::emitTdg(GateApplication app, const IR& ir) {
     };
 }
 
-ordered_json MOSFPrinter::emitRZ(GateApplication app, const IR& ir) {
+ordered_json MOSFPrinter::emitRZ(const GateApplication& app, const IR& ir) {
     if (app.operands.size() != 1)
         throw std::runtime_error("MOSFPrinter: RY gate expects exactly 1 operand.");
     if (app.params.size() != 1)
         throw std::runtime_error("MOSFPrinter: RY gate expects exactly 1 parameter (angle).");
 
     const std::string tgt_var = qubitVarName(app.operands[0], ir);
-    const std::string angle = app.params[0];
+    const std::string angle(app.params[0]);
     double angle_val = parse_angle_expr(angle);
     return ordered_json{
         {"type",   "traverse_to"},
@@ -395,7 +394,7 @@ ordered_json MOSFPrinter::emitRZ(GateApplication app, const IR& ir) {
     };
 }
 
-ordered_json MOSFPrinter::emitT(GateApplication app, const IR& ir) {
+ordered_json MOSFPrinter::emitT(const GateApplication& app, const IR& ir) {
     if (app.operands.size() != 1)
         throw std::runtime_error("MOSFPrinter: T gate expects exactly 1 operand.");
 
@@ -424,7 +423,7 @@ ordered_json MOSFPrinter::emitT(GateApplication app, const IR& ir) {
     };
 }
 
-ordered_json MOSFPrinter::dispatchGate(GateApplication app, const IR &ir) {
+ordered_json MOSFPrinter::dispatchGate(const GateApplication& app, const IR &ir) {
     const auto& gate = ir.getGate(app.gate_id);
     if (gate.name == "x" || gate.name == "cx" ||
         gate.name == "ccx" || gate.name == "mcx") {
@@ -460,13 +459,22 @@ ordered_json MOSFPrinter::dispatchLoop(const LoopApplication& loop, const IR& ir
 
     ordered_json inner_ops = ordered_json::array();
     for (const auto& node : loop.body.body) {
-        if (auto* ga = dynamic_cast<const GateApplication*>(node.get())) {
-            inner_ops.push_back(dispatchGate(*ga, ir));
-        } else if (auto* inner_loop = dynamic_cast<const LoopApplication*>(node.get())) {
-            inner_ops.push_back(dispatchLoop(*inner_loop, ir));
-        } else {
-            throw std::runtime_error(
-                "MOSFPrinter: unsupported node type inside loop body.");
+        switch (node->kind) {
+            case NodeKind::Gate:
+                inner_ops.push_back(dispatchGate(static_cast<const GateApplication&>(*node), ir));
+                break;
+            case NodeKind::Loop:
+                inner_ops.push_back(dispatchLoop(static_cast<const LoopApplication&>(*node), ir));
+                break;
+            case NodeKind::Stream: {
+                const auto& stream = static_cast<const GateStream&>(*node);
+                for (size_t i = 0; i < stream.size(); ++i)
+                    inner_ops.push_back(dispatchGate(stream.unpack(i), ir));
+                break;
+            }
+            default:
+                throw std::runtime_error(
+                    "MOSFPrinter: unsupported node type inside loop body.");
         }
     }
 
@@ -496,15 +504,24 @@ ordered_json MOSFPrinter::dispatchLoop(const LoopApplication& loop, const IR& ir
 ordered_json MOSFPrinter::buildOps(const IR& ir) {
     ordered_json ops_json = ordered_json::array();
     for (auto &node : ir.getGlobalBlock().body) {
-        if (auto* gate_app = dynamic_cast<GateApplication*>(node.get())){
-                ops_json.push_back(dispatchGate(*gate_app, ir));
-        } else if (auto* loop_app = dynamic_cast<LoopApplication*>(node.get())) {
-            ops_json.push_back(dispatchLoop(*loop_app, ir));
-        } else if (auto* cond_app = dynamic_cast<ConditionalApplication*>(node.get())) {
-            //ops_json.push_back(dispatchCond(*cond_app, ir));
-            throw std::runtime_error("MOSFPrinter: conditional applications not yet supported.");
-        } else {
-            throw std::runtime_error("MOSFPrinter: unknown ProgramNode type during ops generation");
+        switch (node->kind) {
+            case NodeKind::Gate:
+                ops_json.push_back(dispatchGate(static_cast<const GateApplication&>(*node), ir));
+                break;
+            case NodeKind::Loop:
+                ops_json.push_back(dispatchLoop(static_cast<const LoopApplication&>(*node), ir));
+                break;
+            case NodeKind::Stream: {
+                const auto& stream = static_cast<const GateStream&>(*node);
+                for (size_t i = 0; i < stream.size(); ++i)
+                    ops_json.push_back(dispatchGate(stream.unpack(i), ir));
+                break;
+            }
+            case NodeKind::Conditional:
+                //ops_json.push_back(dispatchCond(static_cast<const ConditionalApplication&>(*node), ir));
+                throw std::runtime_error("MOSFPrinter: conditional applications not yet supported.");
+            default:
+                throw std::runtime_error("MOSFPrinter: unknown ProgramNode type during ops generation");
         }
     }
 
@@ -518,7 +535,7 @@ void MOSFPrinter::print(const IR& ir, std::ostream& out) {
     mosf_json["version"] = mosf_version;
     mosf_json["tree_id"] = tree_id;
     mosf_json["vars"] = buildVars();
-    mosf_json["x_levels"] = qubit_levels.size();
+    mosf_json["x_levels"] = level_vars.size();
     mosf_json["defs"] = buildDefs();
     mosf_json["ops"]  = buildOps(ir);
 
@@ -24,30 +24,43 @@ void OpenQASMPrinter::printHeader(std::ostream& out) {
 
 void OpenQASMPrinter::printRegisters(const IR& ir, std::ostream& out) {
     for (const auto& reg : ir.getAllRegisters()) {
-        if (reg.size == "0") {
-            // skip zero-size registers (e.g. removed by optimizations)
-            continue;
-        }
-        switch (reg.type) {
-            case RegisterType::Qubit:
-                if (version >= 3) {
-                    out << "qubit " << reg.name << "[" << reg.size << "];\n";
-                } else {
-                    out << "qreg " << reg.name << "[" << reg.size << "];\n";
-                }
-                break;
-            case RegisterType::Int:
-                if (version >= 3) {
-                    out << "int " << reg.name << "[" << reg.size << "];\n";
-                } else {
-                    out << "creg " << reg.name << "[" << reg.size << "];\n";
-                }
-                break;
-        }
+        printRegister(reg, out);
     }
     out << "\n";
 }
 
+void OpenQASMPrinter::printRegister(const RegisterDef& reg, std::ostream& out) {
+    switch (reg.type) {
+        case RegisterType::Qubit:
+            if (version >= 3) {
+                out << "qubit " << reg.name << "[" << reg.size << "];\n";
+            } else {
+                out << "qreg " << reg.name << "[" << reg.size << "];\n";
+            }
+            break;
+        case RegisterType::Int:
+            if (version >= 3) {
+                out << "int " << reg.name << "[" << reg.size << "];\n";
+            } else {
+                out << "creg " << reg.name << "[" << reg.size << "];\n";
+            }
+            break;
+    }
+}
+
+void OpenQASMPrinter::beginStream(std::ostream& out) {
+    printHeader(out);
+}
+
+void OpenQASMPrinter::streamRegister(const RegisterDef& reg, const IR& /*ir*/, std::ostream& out) {
+    // declarations are interleaved with the program, each one precedes its first use
+    printRegister(reg, out);
+}
+
+void OpenQASMPrinter::streamNode(const ProgramNodeBase& node, const IR& ir, std::ostream& out) {
+    printNode(node, ir, out, 0);
+}
+
 void OpenQASMPrinter::printProgram(const IR& ir, std::ostream& out) {
     const Block& blk = ir.getGlobalBlock();
     printBlock(blk, ir, out, 0);
@@ -59,7 +72,7 @@ static std::string indent(int depth) {
 
 static std::string registerRefStr(const RegisterRef& ref, const IR& ir) {
     const RegisterDef& reg = ir.getRegister(ref.reg_id);
-    return reg.name + "[" + ref.qubit_index + "]";
+    return reg.name + "[" + ref.index.str() + "]";
 }
 
 void OpenQASMPrinter::printBlock(const Block& block, const IR& ir,
@@ -71,14 +84,19 @@ void OpenQASMPrinter::printBlock(const Block& block, const IR& ir,
 
 void OpenQASMPrinter::printNode(const ProgramNodeBase& node, const IR& ir,
                                  std::ostream& out, int depth) {
-    if (const auto* gate = dynamic_cast<const GateApplication*>(&node)) {
-        printGateApplication(*gate, ir, out, depth);
-    }
-    else if (const auto* loop = dynamic_cast<const LoopApplication*>(&node)) {
-        printLoopApplication(*loop, ir, out, depth);
-    }
-    else if (const auto* cond = dynamic_cast<const ConditionalApplication*>(&node)) {
-        printConditionalApplication(*cond, ir, out, depth);
+    switch (node.kind) {
+        case NodeKind::Gate:
+            printGateApplication(static_cast<const GateApplication&>(node), ir, out, depth);
+            break;
+        case NodeKind::Loop:
+            printLoopApplication(static_cast<const LoopApplication&>(node), ir, out, depth);
+            break;
+        case NodeKind::Conditional:
+            printConditionalApplication(static_cast<const ConditionalApplication&>(node), ir, out, depth);
+            break;
+        case NodeKind::Stream:
+            printGateStream(static_cast<const GateStream&>(node), ir, out, depth);
+            break;
     }
 }
 
@@ -104,6 +122,32 @@ void OpenQASMPrinter::printGateApplication(const GateApplication& app,
     out << ";\n";
 }
 
+void OpenQASMPrinter::printGateStream(const GateStream& stream,
+                                       const IR& ir,
+                                       std::ostream& out, int depth) {
+    const std::string prefix = indent(depth);
+    for (std::size_t i = 0; i < stream.size(); ++i) {
+        out << prefix << ir.getGate(stream.gates[i]).name;
+
+        const auto params_begin = stream.param_offsets[i];
+        const auto params_end = stream.param_offsets[i + 1];
+        if (params_begin != params_end) {
+            out << "(";
+            for (auto p = params_begin; p < params_end; ++p) {
+                out << (p == params_begin ? "" : ",") << stream.params[p];
+            }
+            out << ")";
+        }
+
+        const auto ops_begin = stream.operand_offsets[i];
+        for (auto j = ops_begin; j < stream.operand_offsets[i + 1]; ++j) {
+            out << (j == ops_begin ? " " : ",")
+                << ir.getRegister(stream.operand_regs[j]).name << "[" << stream.operand_indices[j] << "]";
+        }
+        out << ";\n";
+    }
+}
+
 void OpenQASMPrinter::printLoopApplication(const LoopApplication& loop,
                                             const IR& ir,
                                             std::ostream& out, int depth) {
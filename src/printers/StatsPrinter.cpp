@@ -51,6 +51,26 @@ void StatsPrinter::printRegisters(const IR& ir, std::ostream& out) {
     out << "bits_total   = " << bits_total   << "\n";
 }
 
+void StatsPrinter::beginStream(std::ostream& /*out*/) {
+    _streamed_counts.clear();
+}
+
+void StatsPrinter::streamNode(const ProgramNodeBase& node, const IR& ir, std::ostream& out) {
+    collectNodeCallCounts(node, ir, out, _streamed_counts);
+}
+
+void StatsPrinter::endStream(const IR& ir, std::ostream& out) {
+    printHeader(out);
+    printRegisters(ir, out);
+    out << "\n[gates]\n";
+
+    // used gates that were only called from gate bodies still get a line
+    for (const auto& gate : ir.usedGates()) {
+        _streamed_counts.try_emplace(gate.name, 0);
+    }
+    printGateCounts(out, _streamed_counts);
+}
+
 void StatsPrinter::collectGateCallCounts(const Block& block,
                                         const IR& ir, 
                                         std::ostream& out,
@@ -58,19 +78,42 @@ void StatsPrinter::collectGateCallCounts(const Block& block,
                                         long long>& gate_counts,
                                         long long multiplier) {
     for (const auto& node_ptr : block.body) {
-        const auto* gate_app = dynamic_cast<const GateApplication*>(node_ptr.get());
-        if (gate_app) {
-            const GateDef& gate = ir.getGate(gate_app->gate_id);
-            gate_counts[gate.name] += multiplier;
-        }
+        collectNodeCallCounts(*node_ptr, ir, out, gate_counts, multiplier);
+    }
+}
 
-        const auto* loop_app = dynamic_cast<const LoopApplication*>(node_ptr.get());
-        if (loop_app) {
-            // Recursively collect gate counts from loop body
-            int loop_multiplier = ir.resolveLoopCount(loop_app->values);
-            collectGateCallCounts(loop_app->body, ir, out, gate_counts, multiplier * loop_multiplier);
+void StatsPrinter::collectNodeCallCounts(const ProgramNodeBase& node,
+                                         const IR& ir,
+                                         std::ostream& out,
+                                         std::unordered_map<std::string,
+                                         long long>& gate_counts,
+                                         long long multiplier) {
+    const auto* gate_app = node_cast<GateApplication>(&node);
+    if (gate_app) {
+        const GateDef& gate = ir.getGate(gate_app->gate_id);
+        gate_counts[gate.name] += multiplier;
+    }
+
+    const auto* stream = node_cast<GateStream>(&node);
+    if (stream) {
+        // count by gate id, names are looked up once per distinct gate
+        // stream gate ids are 32-bit, i.e. slot indices of the first generation
+        std::vector<long long> counts(ir.getAllGates().slotCount(), 0);
+        for (auto gate_id : stream->gates) {
+            ++counts[gate_id];
         }
+        for (idGate id = 0; id < counts.size(); ++id) {
+            if (counts[id] != 0) {
+                gate_counts[ir.getGate(id).name] += counts[id] * multiplier;
+            }
+        }
+    }
 
+    const auto* loop_app = node_cast<LoopApplication>(&node);
+    if (loop_app) {
+        // Recursively collect gate counts from loop body
+        int loop_multiplier = ir.resolveLoopCount(loop_app->values);
+        collectGateCallCounts(loop_app->body, ir, out, gate_counts, multiplier * loop_multiplier);
     }
 }
 
@@ -78,11 +121,15 @@ void StatsPrinter::printGates(const IR& ir, std::ostream& out) {
     out << "\n[gates]\n";
 
     std::unordered_map<std::string, long long> gate_counts;
-    for (const auto& gate : ir.getAllGates()) {
-        if (!gate.used) continue; // skip unused gates
+    for (const auto& gate : ir.usedGates()) {
         gate_counts[gate.name] = 0;
     }
     collectGateCallCounts(ir.getGlobalBlock(), ir, out,  gate_counts);
+    printGateCounts(out, gate_counts);
+}
+
+void StatsPrinter::printGateCounts(std::ostream& out,
+                                   const std::unordered_map<std::string, long long>& gate_counts) {
     for (const auto& [gate_name, count] : gate_counts) {
         out << "  " << gate_name << " : count = " << count << "\n";
     }
@@ -93,4 +140,4 @@ void StatsPrinter::printGates(const IR& ir, std::ostream& out) {
         total_calls += gate_count.second;
     }
     out << total_calls << "\n";
-}
\ No newline at end of file
+}
@@ -9,16 +9,10 @@
 
 void StimPrinter::print(const IR& ir, std::ostream& out) {
 
-    _qubit_base.clear();
-    size_t base = 0;
-    for (const auto& reg : ir.getAllRegisters()) {
-        if (reg.type == RegisterType::Qubit) {
-            _qubit_base[reg.name] = base;
-            base += std::stoi(reg.size);  // compile time constant
-        }
-    }
+    _layout = QubitLayout(ir);
+    _composites.clear();
     
-    out << "# Stim circuit from OpenQASM IR (n_qubits=" << base << ")\n";
+    out << "# Stim circuit from OpenQASM IR (n_qubits=" << _layout.qubitCount() << ")\n";
     
     // Printing program
     for (const auto& node_ptr : ir.getGlobalBlock().body) {
@@ -26,27 +20,52 @@ void StimPrinter::print(const IR& ir, std::ostream& out) {
     }
 }
 
-size_t StimPrinter::resolveQubit(const RegisterRef& ref, const IR& ir) const {
-    const auto& reg = ir.getRegister(ref.reg_id);
+void StimPrinter::beginStream(std::ostream& out) {
+    _layout = QubitLayout();
+    _composites.clear();
+
+    // the qubit count is only known at the end, see endStream
+    out << "# Stim circuit from OpenQASM IR (streamed)\n";
+}
+
+void StimPrinter::streamRegister(const RegisterDef& reg, const IR& ir, std::ostream& /*out*/) {
+    _layout.add(ir.getRegisterId(reg.name), reg);
+}
+
+void StimPrinter::streamNode(const ProgramNodeBase& node, const IR& ir, std::ostream& out) {
+    printProgramNode(node, ir, out);
+}
+
+void StimPrinter::endStream(const IR& /*ir*/, std::ostream& out) {
+    out << "# n_qubits=" << _layout.qubitCount() << "\n";
+}
+
+size_t StimPrinter::registerBase(idRegister reg_id, const IR& ir) const {
+    const auto& reg = ir.getRegister(reg_id);
     if (reg.type != RegisterType::Qubit) {
         throw std::runtime_error("Non-qubit register in gate");
     }
-    
-    // TODO: evaluate ref.qubit_index as constant expression
-    // for now, just integer index
-    size_t idx = std::stoi(ref.qubit_index);
-    auto it = _qubit_base.find(reg.name);
-    if (it == _qubit_base.end()) {
+
+    if (!_layout.contains(reg_id)) {
         throw std::runtime_error("Unknown qubit register: " + reg.name);
     }
-    return it->second + idx;
+    return _layout.base(reg_id);
+}
+
+size_t StimPrinter::resolveQubit(const RegisterRef& ref, const IR& ir) const {
+    if (!ref.index.isLiteral()) {
+        throw std::runtime_error("Non-constant qubit index: "
+            + ir.getRegister(ref.reg_id).name + "[" + ref.index.str() + "]");
+    }
+    size_t idx = ref.index.offset;
+    return registerBase(ref.reg_id, ir) + idx;
 }
 
 void StimPrinter::printAtomicGate(const GateApplication& app, 
                                   const GateDef &gdef, 
                                   const IR& ir, 
                                   std::ostream& out) {
-    auto it = _gate_map.find(gdef.name);
+    auto it = _gate_map.find(gdef.name.id());
     if (it != _gate_map.end()) {
         // print the gate identificator
         out << it->second;
@@ -64,7 +83,12 @@ void StimPrinter::printCompositeGate(const GateApplication& app,
                                   const GateDef &gdef, 
                                   const IR& ir, 
                                   std::ostream& out) { 
-    // TODO: printing composite gates
+    // flattened once per gate, see inline.hpp
+    GateApplication atomic;
+    for (const auto& flat : _composites.flatten(ir, app.gate_id)) {
+        CompositeTemplates::instantiate(flat, app, atomic);
+        printAtomicGate(atomic, ir.getGate(atomic.gate_id), ir, out);
+    }
 }
 
 
@@ -81,6 +105,40 @@ void StimPrinter::printGate(const GateApplication& app, const IR& ir, std::ostre
 }
 
 
+void StimPrinter::printGateStream(const GateStream& stream, const IR& ir, std::ostream& out) {
+    // gate names and register bases are resolved once per stream, not per gate
+    // stream ids are 32-bit, i.e. slot indices of the first generation
+    std::vector<const std::string*> stim_names(ir.getAllGates().slotCount(), nullptr);
+    constexpr size_t UNRESOLVED = static_cast<size_t>(-1);
+    std::vector<size_t> bases(ir.getAllRegisters().slotCount(), UNRESOLVED);
+
+    for (size_t i = 0; i < stream.size(); ++i) {
+        const auto gate_id = stream.gates[i];
+        if (!stim_names[gate_id]) {
+            const auto& gdef = ir.getGate(gate_id);
+            if (gdef.kind != GateKind::Atomic) {
+                printCompositeGate(stream.unpack(i), gdef, ir, out);
+                continue;
+            }
+            auto it = _gate_map.find(gdef.name.id());
+            if (it == _gate_map.end()) {
+                throw std::runtime_error("Unsupported atomic gate: " + gdef.name);
+            }
+            stim_names[gate_id] = &it->second;
+        }
+
+        out << *stim_names[gate_id];
+        for (auto j = stream.operand_offsets[i]; j < stream.operand_offsets[i + 1]; ++j) {
+            const auto reg_id = stream.operand_regs[j];
+            if (bases[reg_id] == UNRESOLVED) {
+                bases[reg_id] = registerBase(reg_id, ir);
+            }
+            out << " " << bases[reg_id] + static_cast<size_t>(stream.operand_indices[j]);
+        }
+        out << "\n";
+    }
+}
+
 void StimPrinter::printBlock(const Block& block, const IR& ir, std::ostream& out) {
     out << "{\n";
     for (const auto& node_ptr : block.body) {
@@ -91,21 +149,29 @@ void StimPrinter::printBlock(const Block& block, const IR& ir, std::ostream& out
 
 void StimPrinter::printProgramNode(const ProgramNodeBase& node, 
                                       const IR& ir, std::ostream& out) {
-    if (auto* app = dynamic_cast<const GateApplication*>(&node)) {
-        printGate(*app, ir, out);
-    } else if (auto* loop = dynamic_cast<const LoopApplication*>(&node)) {
-        if (auto* interval = std::get_if<Interval>(&loop->values)) {
-            // (end - start)/step + 1
-            size_t start = std::stoi(interval->start);
-            size_t end = std::stoi(interval->end);
-            size_t step = std::stoi(interval->step);
-            size_t reps = (end - start) / step + 1;
-            out << "REPEAT " << reps << " ";
-            printBlock(loop->body, ir, out);
+    switch (node.kind) {
+        case NodeKind::Gate:
+            printGate(static_cast<const GateApplication&>(node), ir, out);
+            break;
+        case NodeKind::Loop: {
+            const auto& loop = static_cast<const LoopApplication&>(node);
+            if (auto* interval = std::get_if<Interval>(&loop.values)) {
+                // (end - start)/step + 1
+                size_t start = std::stoi(interval->start);
+                size_t end = std::stoi(interval->end);
+                size_t step = std::stoi(interval->step);
+                size_t reps = (end - start) / step + 1;
+                out << "REPEAT " << reps << " ";
+                printBlock(loop.body, ir, out);
+            }
+            break;
         }
-    } else if (auto* cond = dynamic_cast<const ConditionalApplication*>(&node)) {
-        throw std::runtime_error("Stim does not support Conditionals");
-    } else {
-        throw std::runtime_error("Unsupported program node by Stim (only REPEAT blocks supported).");
+        case NodeKind::Stream:
+            printGateStream(static_cast<const GateStream&>(node), ir, out);
+            break;
+        case NodeKind::Conditional:
+            throw std::runtime_error("Stim does not support Conditionals");
+        default:
+            throw std::runtime_error("Unsupported program node by Stim (only REPEAT blocks supported).");
     }
 }
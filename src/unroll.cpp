@@ -1,29 +1,380 @@
+/**
+ * @file unroll.cpp
+ * @author Filip Novak
+ * @date 2026-10-16
+ */
+#include "unroll.hpp"
 
-// // Returns true if the loop's iteration values can be fully resolved at compile time.
-// static bool isUnrollable(const LoopApplication& loop);
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
 
-// // Returns the ordered list of string values the loop variable takes.
-// // Only call if isUnrollable() returned true.
-// static std::vector<std::string> getIterationValues(const LoopApplication& loop);
+namespace {
 
-// // Deep-clones a single ProgramNodePtr (GateApplication, LoopApplication, ConditionalApplication).
-// static ProgramNodePtr cloneNode(const ProgramNodePtr& node);
+bool isIdentifierStart(char c) {
+    return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+}
 
-// // Deep-clones a Block (variables + body).
-// static Block cloneBlock(const Block& block);
+bool isIdentifierChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
 
-// // Replaces all whole-word occurrences of `var` with `value` in a string expression.
-// // e.g. substituteVar("i + 2", "i", "3") -> "3 + 2"
-// //      substituteVar("width", "i", "3") -> "width"  (no match)
-// static std::string substituteVar(const std::string& expr,
-//                                  const std::string& var,
-//                                  const std::string& value);
+// a value that needs no parentheses when substituted into an expression
+bool isSimpleValue(std::string_view text) {
+    return !text.empty() && std::all_of(text.begin(), text.end(),
+        [](char c) { return isIdentifierChar(c) || c == '.'; });
+}
 
-// // Substitutes the loop variable throughout all RegisterRefs and expressions in a Block.
-// static void substituteInBlock(Block& block,
-//                                const std::string& var,
-//                                const std::string& value);
+std::optional<std::ptrdiff_t> integerValue(std::string_view text, const IR& ir) {
+    auto index = parseIndexExpr(text, [&](std::string_view name) { return ir.getConstantValue(name); });
+    if (!index.isLiteral()) {
+        return std::nullopt;
+    }
+    return index.offset;
+}
 
-// // Recursive worker — returns a new body with all unrollable loops expanded.
-// // Recurses bottom-up: inner loops are processed before outer ones.
-// static std::vector<ProgramNodePtr> unrollBlock(std::vector<ProgramNodePtr>& body);
\ No newline at end of file
+} // namespace
+
+std::vector<IterationValue> iterationValues(const LoopValues& values, const IR& ir) {
+    std::vector<IterationValue> result;
+
+    if (const auto* interval = std::get_if<Interval>(&values)) {
+        const auto start = integerValue(interval->start, ir);
+        const auto step = integerValue(interval->step, ir);
+        const auto end = integerValue(interval->end, ir);
+        if (!start || !step || !end) {
+            throw std::runtime_error("non-constant range [" + interval->start + ":"
+                + interval->step + ":" + interval->end + "]");
+        }
+        if (*step == 0) {
+            throw std::runtime_error("zero step");
+        }
+
+        const auto count = ir.resolveLoopCount(
+            Interval{std::to_string(*start), std::to_string(*step), std::to_string(*end)});
+        result.reserve(std::max(count, 0));
+        for (int i = 0; i < count; ++i) {
+            const auto value = *start + i * *step;
+            result.push_back({std::to_string(value), value});
+        }
+    } else if (const auto* list = std::get_if<std::vector<std::string>>(&values)) {
+        result.reserve(list->size());
+        for (const auto& text : *list) {
+            result.push_back({text, integerValue(text, ir)});
+        }
+    } else {
+        throw std::runtime_error("iterates over " + std::get<std::string>(values)
+            + ", not a compile-time constant list");
+    }
+    return result;
+}
+
+LoopUnroller::LoopUnroller(IR& ir, const passes::UnrollOptions& options)
+    : _ir(ir), _options(options), _remaining(options.budget) {}
+
+passes::UnrollStats LoopUnroller::run() {
+    rewrite(_ir.getGlobalBlock().body);
+    return _stats;
+}
+
+// ---- substitution ----
+
+const LoopUnroller::Binding* LoopUnroller::lookup(SymbolId symbol) const {
+    for (auto it = _bindings.rbegin(); it != _bindings.rend(); ++it) {
+        if (it->symbol == symbol) {
+            return &*it;
+        }
+    }
+    return nullptr;
+}
+
+std::string LoopUnroller::substituteText(std::string_view text) const {
+    std::string result;
+    result.reserve(text.size());
+
+    std::size_t i = 0;
+    while (i < text.size()) {
+        if (!isIdentifierStart(text[i]) || (i > 0 && isIdentifierChar(text[i - 1]))) {
+            result += text[i++];
+            continue;
+        }
+        auto end = i;
+        while (end < text.size() && isIdentifierChar(text[end])) {
+            ++end;
+        }
+        const auto word = text.substr(i, end - i);
+        i = end;
+
+        const auto symbol = Interner::global().find(word);
+        const auto* binding = symbol ? lookup(*symbol) : nullptr;
+        if (!binding || binding->kind == Binding::Kind::Shadow) {
+            result += word;
+        } else if (binding->kind == Binding::Kind::Shift) {
+            if (binding->shift == 0) {
+                result += word;
+            } else {
+                result += "(" + std::string(word) + (binding->shift > 0 ? "+" : "")
+                    + std::to_string(binding->shift) + ")";
+            }
+        } else {
+            const auto& value = binding->value->text;
+            result += isSimpleValue(value) ? value : "(" + value + ")";
+        }
+    }
+    return result;
+}
+
+IndexExpr LoopUnroller::substituteIndex(const IndexExpr& index) const {
+    if (!index.isAffine()) {
+        auto text = substituteText(index.opaque);
+        if (text == index.opaque) {
+            return index;
+        }
+        // the substituted values may make it affine, or even a literal
+        return parseIndexExpr(text, [&](std::string_view name) { return _ir.getConstantValue(name); });
+    }
+    if (!index.symbol) {
+        return index;
+    }
+
+    const auto* binding = lookup(*index.symbol);
+    if (!binding || binding->kind == Binding::Kind::Shadow) {
+        return index;
+    }
+    auto result = index;
+    if (binding->kind == Binding::Kind::Shift) {
+        result.offset += index.scale * binding->shift;
+        return result;
+    }
+    if (!binding->value->integer) {
+        throw KeepLoop{binding->symbol, "non-integer value " + binding->value->text + " in a qubit index"};
+    }
+    return IndexExpr::literal(index.evaluate(*binding->value->integer));
+}
+
+LoopValues LoopUnroller::substituteValues(const LoopValues& values) const {
+    if (const auto* interval = std::get_if<Interval>(&values)) {
+        return Interval{substituteText(interval->start), substituteText(interval->step),
+                        substituteText(interval->end)};
+    }
+    if (const auto* list = std::get_if<std::vector<std::string>>(&values)) {
+        std::vector<std::string> result;
+        result.reserve(list->size());
+        for (const auto& text : *list) {
+            result.push_back(substituteText(text));
+        }
+        return result;
+    }
+    return values;
+}
+
+// ---- copying ----
+
+void LoopUnroller::emitGates(std::size_t count) {
+    if (_unrolling == 0) {
+        return;   // not a copy, the gate is there already
+    }
+    if (count > _remaining) {
+        throw KeepLoop{std::nullopt, ""};
+    }
+    _remaining -= count;
+    _stats.emitted_gates += count;
+}
+
+void LoopUnroller::rewrite(std::vector<ProgramNodePtr>& body) {
+    // outside of loops nodes stay where they are, only loops are replaced
+    std::vector<ProgramNodePtr> new_body;
+    new_body.reserve(body.size());
+    for (auto& node_ptr : body) {
+        switch (node_ptr->kind) {
+            case NodeKind::Loop:
+                copyLoop(static_cast<const LoopApplication&>(*node_ptr), new_body);
+                break;
+            case NodeKind::Conditional: {
+                auto& cond = static_cast<ConditionalApplication&>(*node_ptr);
+                rewrite(cond.then_body);
+                rewrite(cond.else_body);
+                new_body.push_back(std::move(node_ptr));
+                break;
+            }
+            default:
+                new_body.push_back(std::move(node_ptr));
+                break;
+        }
+    }
+    body = std::move(new_body);
+}
+
+void LoopUnroller::copyBody(const std::vector<ProgramNodePtr>& body, std::vector<ProgramNodePtr>& out) {
+    for (const auto& node_ptr : body) {
+        copyNode(*node_ptr, out);
+    }
+}
+
+void LoopUnroller::copyNode(const ProgramNodeBase& node, std::vector<ProgramNodePtr>& out) {
+    auto& arena = _ir.arena();
+    switch (node.kind) {
+        case NodeKind::Gate: {
+            const auto& app = static_cast<const GateApplication&>(node);
+            emitGates(1);
+            auto copy = makeNode<GateApplication>(arena);
+            copy->gate_id = app.gate_id;
+            copy->operands.reserve(app.operands.size());
+            for (const auto& op : app.operands) {
+                copy->operands.push_back(RegisterRef{op.reg_id, substituteIndex(op.index)});
+            }
+            copy->params.reserve(app.params.size());
+            for (const auto& param : app.params) {
+                copy->params.emplace_back(substituteText(param));
+            }
+            out.push_back(std::move(copy));
+            break;
+        }
+        case NodeKind::Stream: {
+            // literal indices, only the parameters can use the variable
+            const auto& stream = static_cast<const GateStream&>(node);
+            emitGates(stream.size());
+            auto copy = makeNode<GateStream>(arena);
+            copy->gates.reserve(stream.size());
+            copy->operand_offsets.reserve(stream.size() + 1);
+            copy->param_offsets.reserve(stream.size() + 1);
+            for (std::size_t i = 0; i < stream.size(); ++i) {
+                copy->append(stream, i);
+            }
+            for (auto& param : copy->params) {
+                param = substituteText(param);
+            }
+            out.push_back(std::move(copy));
+            break;
+        }
+        case NodeKind::Conditional: {
+            const auto& cond = static_cast<const ConditionalApplication&>(node);
+            auto copy = makeNode<ConditionalApplication>(arena);
+            copy->condition_expr = substituteText(cond.condition_expr);
+            copyBody(cond.then_body, copy->then_body);
+            copyBody(cond.else_body, copy->else_body);
+            out.push_back(std::move(copy));
+            break;
+        }
+        case NodeKind::Loop:
+            copyLoop(static_cast<const LoopApplication&>(node), out);
+            break;
+    }
+}
+
+void LoopUnroller::copyLoop(const LoopApplication& loop, std::vector<ProgramNodePtr>& out) {
+    if (!loop.body.variables.empty()) {
+        keepLoop(loop, "declares variables", out);
+        return;
+    }
+
+    const auto values = substituteValues(loop.values);
+    std::vector<IterationValue> iterations;
+    try {
+        iterations = iterationValues(values, _ir);
+    } catch (const std::runtime_error& e) {
+        keepLoop(loop, e.what(), out);
+        return;
+    }
+
+    // state to roll back to if the loop is kept after all
+    const auto out_size = out.size();
+    const auto bindings = _bindings.size();
+    const auto unrolling = _unrolling;
+    const auto remaining = _remaining;
+    const auto unrolled_loops = _stats.unrolled_loops;
+    const auto emitted_gates = _stats.emitted_gates;
+    const auto kept_loops = _stats.kept_loops.size();
+
+    try {
+        unrollLoop(loop, values, iterations, out);
+    } catch (const KeepLoop& keep) {
+        // a value problem is the loop's own, the budget one the outermost unrolled loop's
+        const bool own = keep.variable
+            ? _bindings.size() > bindings && lookup(*keep.variable) == &_bindings[bindings]
+            : unrolling == 0;
+        if (!own) {
+            throw;
+        }
+        while (out.size() > out_size) {
+            out.pop_back();
+        }
+        _bindings.resize(bindings);
+        _unrolling = unrolling;
+        _remaining = remaining;
+        _stats.unrolled_loops = unrolled_loops;
+        _stats.emitted_gates = emitted_gates;
+        _stats.kept_loops.resize(kept_loops);
+
+        keepLoop(loop, keep.variable ? keep.reason
+            : "unrolling exceeds the budget of " + std::to_string(remaining) + " more gates", out);
+    }
+}
+
+void LoopUnroller::unrollLoop(const LoopApplication& loop, const LoopValues& values,
+                              const std::vector<IterationValue>& iterations,
+                              std::vector<ProgramNodePtr>& out) {
+    const Binding binding{intern(loop.variable), &loop.variable, Binding::Kind::Value};
+    ++_unrolling;
+    ++_stats.unrolled_loops;
+
+    const std::size_t factor = _options.factor;
+    std::size_t unrolled = 0;   // iterations left to the partially unrolled loop
+
+    if (factor >= 2 && std::holds_alternative<Interval>(values) && iterations.size() > factor) {
+        const auto start = *iterations[0].integer;
+        const auto step = *iterations[1].integer - start;
+        const auto trips = iterations.size() / factor;
+        unrolled = trips * factor;
+
+        auto copy = makeNode<LoopApplication>(_ir.arena());
+        copy->type = loop.type;
+        copy->variable = loop.variable;
+        copy->values = Interval{
+            std::to_string(start),
+            std::to_string(step * static_cast<std::ptrdiff_t>(factor)),
+            std::to_string(start + static_cast<std::ptrdiff_t>(unrolled - factor) * step)};
+        for (std::size_t k = 0; k < factor; ++k) {
+            auto shifted = binding;
+            shifted.kind = Binding::Kind::Shift;
+            shifted.shift = static_cast<std::ptrdiff_t>(k) * step;
+            _bindings.push_back(shifted);
+            copyBody(loop.body.body, copy->body.body);
+            _bindings.pop_back();
+        }
+        out.push_back(std::move(copy));
+    }
+
+    for (auto i = unrolled; i < iterations.size(); ++i) {
+        auto bound = binding;
+        bound.value = &iterations[i];
+        _bindings.push_back(bound);
+        copyBody(loop.body.body, out);
+        _bindings.pop_back();
+    }
+
+    --_unrolling;
+}
+
+void LoopUnroller::keepLoop(const LoopApplication& loop, const std::string& reason,
+                            std::vector<ProgramNodePtr>& out) {
+    auto line = "loop over " + loop.variable + ": " + reason;
+    if (std::find(_stats.kept_loops.begin(), _stats.kept_loops.end(), line) == _stats.kept_loops.end()) {
+        _stats.kept_loops.push_back(std::move(line));
+    }
+
+    auto copy = makeNode<LoopApplication>(_ir.arena());
+    copy->type = loop.type;
+    copy->variable = loop.variable;
+    copy->values = substituteValues(loop.values);
+    copy->body.variables = loop.body.variables;
+
+    // the variable shadows any outer one of the same name; inner loops may still unroll
+    _bindings.push_back({intern(loop.variable), &loop.variable, Binding::Kind::Shadow});
+    copyBody(loop.body.body, copy->body.body);
+    _bindings.pop_back();
+
+    out.push_back(std::move(copy));
+}
+
+/* EOF unroll.cpp */
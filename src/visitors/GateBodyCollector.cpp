@@ -14,19 +14,28 @@ std::any ProgramCollector::gateBody_visitGateCallStatement(
 
     placement.gate_name = ctx->Identifier()->getText();
     auto sym = _scopes.lookupSymbol(placement.gate_name);
-    if (!sym || sym->kind != SymbolKind::Gate) {
-        throw std::runtime_error(
-            "Unknown gate '" + placement.gate_name + "' in gate body");
-    }
-
-    if (auto p = std::get_if<size_t>(&sym->ir_ref)) {
-        placement.gate_id = *p;
+    if (!sym && collect_headers) {
+        // may be defined further down, resolved after the walk
+        placement.gate_id = UNRESOLVED_GATE;
+        auto gate_id = _ir.getGateId(current_gate->name);
+        if (pending_gate_bodies.empty() || pending_gate_bodies.back() != gate_id) {
+            pending_gate_bodies.push_back(gate_id);
+        }
     } else {
-        throw std::runtime_error("Internal error: Symbol does not contain a gate ID");
-    }
+        if (!sym || sym->kind != SymbolKind::Gate) {
+            throw std::runtime_error(
+                "Unknown gate '" + placement.gate_name + "' in gate body");
+        }
+
+        if (auto p = std::get_if<size_t>(&sym->ir_ref)) {
+            placement.gate_id = *p;
+        } else {
+            throw std::runtime_error("Internal error: Symbol does not contain a gate ID");
+        }
 
-    // mark used for later print of only used gates
-    _ir.markGateUsed(placement.gate_id);
+        // mark used for later print of only used gates
+        markUsed(placement.gate_id);
+    }
 
 
     auto operandCtxs = ctx->gateOperandList()->gateOperand();
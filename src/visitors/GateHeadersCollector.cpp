@@ -9,11 +9,31 @@
 
 #include "../../inc/visitors/GateHeadersCollector.hpp"
 #include "../../inc/utils.hpp"
+#include "../../inc/GateLibrary.hpp"
 
 GateHeadersCollector::GateHeadersCollector(IR& ir, ScopeManager& scopes) : _ir(ir), _scopes(scopes) {}
 
 std::any GateHeadersCollector::visitGateStatement(
     qasm3Parser::GateStatementContext *ctx) {
+    collectGateHeader(ctx, _ir, _scopes);
+    return nullptr;
+}
+
+std::any GateHeadersCollector::visitDefStatement(
+    qasm3Parser::DefStatementContext* ctx) {
+    collectDefHeader(ctx, _ir, _scopes);
+    return nullptr;
+}
+
+std::any GateHeadersCollector::visitIncludeStatement(
+    qasm3Parser::IncludeStatementContext* ctx) {
+    gate_library::include(
+        gate_library::includeName(ctx->StringLiteral()->getText()), _ir, _scopes);
+    return nullptr;
+}
+
+std::size_t GateHeadersCollector::collectGateHeader(
+    qasm3Parser::GateStatementContext *ctx, IR& ir, ScopeManager& scopes) {
     
     GateDef gate;
     gate.name = ctx->Identifier()->getText();
@@ -44,19 +64,19 @@ std::any GateHeadersCollector::visitGateStatement(
 
     gate.semantics = CompositeGateBody{};
 
-    auto id = _ir.addGate(gate);
+    auto id = ir.addGate(gate);
 
-    _scopes.addSymbol(Symbol{
+    scopes.addSymbol(Symbol{
         .name = gate.name,
         .kind = SymbolKind::Gate,
         .ir_ref = id,
     });
     
-    return nullptr;
+    return id;
 }
 
-std::any GateHeadersCollector::visitDefStatement(
-    qasm3Parser::DefStatementContext* ctx) {
+std::size_t GateHeadersCollector::collectDefHeader(
+    qasm3Parser::DefStatementContext* ctx, IR& ir, ScopeManager& scopes) {
     
     SubroutineDef subroutine;
     subroutine.name = ctx->Identifier()->getText();
@@ -86,15 +106,15 @@ std::any GateHeadersCollector::visitDefStatement(
     }
 
     std::string name = ctx->Identifier()->getText();
-    auto id = _ir.addSubroutine(std::move(subroutine));
+    auto id = ir.addSubroutine(std::move(subroutine));
 
-    _scopes.addSymbol(Symbol{
+    scopes.addSymbol(Symbol{
         .name = name,
         .kind = SymbolKind::Subroutine,
         .ir_ref = id,
     });
 
-    return nullptr;
+    return id;
 }
 
 /* EOF GateHeadersCollector*/
@@ -6,26 +6,39 @@
 
 #include "../../inc/visitors/ProgramCollector.hpp"
 #include "../../inc/utils.hpp"
+#include "../../inc/visitors/GateHeadersCollector.hpp"
+#include "../../inc/GateLibrary.hpp"
 
 ProgramCollector::ProgramCollector(
-    IR& ir, ScopeManager& scopes): _ir(ir), _scopes(scopes) {
+    IR& ir, ScopeManager& scopes): _ir(ir), _scopes(scopes), _arena(ir.arena()) {
     block_stack.push_back(&ir.getGlobalBlock());
 }
 
+ProgramCollector::ProgramCollector(
+    IR& ir, ScopeManager& scopes, Block& target,
+    std::unordered_set<std::size_t>& used_gates, Arena& arena)
+    : _ir(ir), _scopes(scopes), _arena(arena), used_gates(&used_gates) {
+    block_stack.push_back(&target);
+}
+
 std::any ProgramCollector::inProgram_visitGateCallStatement(
     qasm3Parser::GateCallStatementContext* ctx) {
-    auto application = std::make_unique<GateApplication>();
+    auto application = makeNode<GateApplication>(_arena);
 
     const std::string gate_name = ctx->Identifier()->getText();
     auto* sym = _scopes.lookupSymbol(gate_name);
 
-    if (!sym || sym->kind != SymbolKind::Gate) {
+    if (!sym && collect_headers) {
+        // may be defined further down, resolved after the walk
+        application->gate_id = UNRESOLVED_GATE;
+        pending_applications.emplace_back(application.get(), gate_name);
+    } else if (!sym || sym->kind != SymbolKind::Gate) {
         throw std::runtime_error("Unknown gate: " + gate_name);
+    } else {
+        application->gate_id = std::get<size_t>(sym->ir_ref);
+        markUsed(application->gate_id);
     }
 
-    application->gate_id = std::get<size_t>(sym->ir_ref);
-    _ir.markGateUsed(application->gate_id);
-
     auto operandCtxs = ctx->gateOperandList()->gateOperand();
 
     for (auto* operandCtx : operandCtxs) {
@@ -53,10 +66,10 @@ std::any ProgramCollector::inProgram_visitGateCallStatement(
                 throw std::runtime_error("Index operator has no expression");
             }
 
-            // TODO: replace with ExprPtr
-            ref.qubit_index = exprs[0]->getText();
+            ref.index = parseIndexExpr(exprs[0]->getText(),
+                [this](std::string_view name) { return constantValue(name); });
         } else {
-            ref.qubit_index = "0";
+            ref.index = IndexExpr::literal(0);
         }
 
         application->operands.push_back(std::move(ref));
@@ -64,7 +77,7 @@ std::any ProgramCollector::inProgram_visitGateCallStatement(
 
     if (ctx->expressionList()) {
         for (auto* expr : ctx->expressionList()->expression()) {
-            application->params.push_back(expr->getText());
+            application->params.emplace_back(expr->getText());
         }
     }
 
@@ -76,7 +89,7 @@ std::any ProgramCollector::inProgram_visitForStatement(
     qasm3Parser::ForStatementContext *ctx) {
     _scopes.enterScope(ScopeKind::Block);
 
-    auto loop = std::make_unique<LoopApplication>();
+    auto loop = makeNode<LoopApplication>(_arena);
 
     // Parse loop variable type
     loop->type = TypeExpr{
@@ -185,6 +198,9 @@ std::any ProgramCollector::visitConstDeclarationStatement(
 
 std::any ProgramCollector::visitGateStatement(
     qasm3Parser::GateStatementContext *ctx) {
+    if (collect_headers) {
+        GateHeadersCollector::collectGateHeader(ctx, _ir, _scopes);
+    }
     current_gate = &_ir.getGate(ctx->Identifier()->getText());
     _scopes.enterScope(ScopeKind::GateOrSubroutine);
     
@@ -221,7 +237,10 @@ std::any ProgramCollector::visitGateStatement(
 
 std::any ProgramCollector::visitDefStatement(
     qasm3Parser::DefStatementContext* ctx) {
-    
+    if (collect_headers) {
+        GateHeadersCollector::collectDefHeader(ctx, _ir, _scopes);
+    }
+
     auto& subroutine = _ir.getSubroutine(ctx->Identifier()->getText());
 
     // Process body
@@ -244,6 +263,16 @@ std::any ProgramCollector::visitDefStatement(
     return nullptr;
 }
 
+std::any ProgramCollector::visitIncludeStatement(
+    qasm3Parser::IncludeStatementContext* ctx) {
+    // in two-pass mode GateHeadersCollector has done this already
+    if (collect_headers) {
+        gate_library::include(
+            gate_library::includeName(ctx->StringLiteral()->getText()), _ir, _scopes);
+    }
+    return nullptr;
+}
+
 std::any ProgramCollector::visitGateCallStatement(qasm3Parser::GateCallStatementContext* ctx) {
     if (current_gate) {
         return gateBody_visitGateCallStatement(ctx);
@@ -263,4 +292,61 @@ std::any ProgramCollector::visitForStatement(qasm3Parser::ForStatementContext *c
     _scopes.exitScope();
     return nullptr;
 }
+void ProgramCollector::markUsed(idGate id) {
+    if (used_gates) {
+        used_gates->insert(id);
+    } else {
+        _ir.markGateUsed(id);
+    }
+}
+
+std::optional<std::ptrdiff_t> ProgramCollector::constantValue(std::string_view name) const {
+    // a loop variable or parameter may shadow a global const
+    auto* sym = _scopes.lookupSymbol(name);
+    if (!sym || sym->kind != SymbolKind::ConstVar) {
+        return std::nullopt;
+    }
+    return _ir.getConstantValue(name);
+}
+
+void ProgramCollector::resolvePlacements(std::vector<GateStmt>& body) {
+    for (auto& stmt : body) {
+        if (auto* loop = std::get_if<RepeatBlock>(&stmt)) {
+            resolvePlacements(loop->body);
+            continue;
+        }
+
+        auto& placement = std::get<GatePlacement>(stmt);
+        if (placement.gate_id != UNRESOLVED_GATE) {
+            continue;
+        }
+
+        auto* sym = _scopes.lookupSymbol(placement.gate_name);
+        if (!sym || sym->kind != SymbolKind::Gate) {
+            throw std::runtime_error(
+                "Unknown gate '" + placement.gate_name + "' in gate body");
+        }
+        placement.gate_id = std::get<size_t>(sym->ir_ref);
+        markUsed(placement.gate_id);
+    }
+}
+
+void ProgramCollector::resolveForwardReferences() {
+    for (auto& [application, gate_name] : pending_applications) {
+        auto* sym = _scopes.lookupSymbol(gate_name);
+        if (!sym || sym->kind != SymbolKind::Gate) {
+            throw std::runtime_error("Unknown gate: " + gate_name);
+        }
+        application->gate_id = std::get<size_t>(sym->ir_ref);
+        markUsed(application->gate_id);
+    }
+    pending_applications.clear();
+
+    for (auto gate_id : pending_gate_bodies) {
+        auto& gate = _ir.getGate(gate_id);
+        resolvePlacements(std::get<CompositeGateBody>(gate.semantics).body);
+    }
+    pending_gate_bodies.clear();
+}
+
 /* EOF ProgramCollector.cpp */
\ No newline at end of file